@@ -0,0 +1,209 @@
+#pragma once
+
+// The parts of openFrameworks that ofxBinaryCommunicator uses, so the addon builds as a plain
+// C++17 program on Linux and macOS (benchmark, tests, CI). Not a replacement for openFrameworks:
+// events are synchronous and thread safe like ofEvent, but ofSerial has no ports.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define OF_VERSION_MAJOR 0
+#define OF_VERSION_MINOR 12
+
+using namespace std;
+
+// Time since the program started
+namespace ofShim {
+    inline std::chrono::steady_clock::time_point& startTime() {
+        static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+    }
+    // Taken during static initialization, so the first call doesn't return 0
+    static const std::chrono::steady_clock::time_point& startTimeInitializer = startTime();
+}
+
+inline uint64_t ofGetElapsedTimeMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ofShim::startTime()).count();
+}
+inline uint64_t ofGetElapsedTimeMillis() { return ofGetElapsedTimeMicros() / 1000; }
+inline float ofGetElapsedTimef() { return ofGetElapsedTimeMicros() * 1e-6f; }
+inline void ofSleepMillis(int millis) { std::this_thread::sleep_for(std::chrono::milliseconds(millis)); }
+
+// Logging: ofLogNotice() << "message"; one line per statement, on stderr
+class ofLog {
+public:
+    explicit ofLog(const string& module = "") {
+        if (!module.empty()) message << "[" << module << "] ";
+    }
+    ofLog(ofLog&& other) : message(std::move(other.message)) {}
+    ~ofLog() {
+        string text = message.str();
+        if (!text.empty()) std::cerr << text << std::endl;
+    }
+    template<typename T>
+    ofLog& operator<<(const T& value) {
+        message << value;
+        return *this;
+    }
+
+private:
+    std::ostringstream message;
+};
+inline ofLog ofLogNotice(const string& module = "") { return ofLog(module); }
+inline ofLog ofLogWarning(const string& module = "") { return ofLog(module); }
+inline ofLog ofLogError(const string& module = "") { return ofLog(module); }
+inline ofLog ofLogVerbose(const string& = "") { return ofLog(); }
+
+template<typename T>
+string ofToString(const T& value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+inline int ofToInt(const string& text) { return atoi(text.c_str()); }
+inline string ofToDataPath(const string& path, bool = false) { return path; }
+inline vector<string> ofSplitString(const string& source, const string& delimiter, bool ignoreEmpty = false, bool trim = false) {
+    vector<string> result;
+    size_t begin = 0;
+    for (;;) {
+        size_t end = delimiter.empty() ? string::npos : source.find(delimiter, begin);
+        string part = source.substr(begin, end == string::npos ? string::npos : end - begin);
+        if (trim) {
+            size_t first = part.find_first_not_of(" \t\r\n");
+            size_t last = part.find_last_not_of(" \t\r\n");
+            part = first == string::npos ? "" : part.substr(first, last - first + 1);
+        }
+        if (!ignoreEmpty || !part.empty()) result.push_back(part);
+        if (end == string::npos) break;
+        begin = end + delimiter.size();
+    }
+    return result;
+}
+
+// Events: listeners run synchronously in ofNotifyEvent(), on the notifying thread. Several threads
+// may notify at once. An ofEventListener removes its listener when it is destroyed.
+class ofEventListener {
+public:
+    ofEventListener() {}
+    explicit ofEventListener(std::function<void()> remove) : remove(std::move(remove)) {}
+    ofEventListener(ofEventListener&& other) : remove(std::move(other.remove)) { other.remove = nullptr; }
+    ofEventListener& operator=(ofEventListener&& other) {
+        if (this != &other) {
+            unsubscribe();
+            remove = std::move(other.remove);
+            other.remove = nullptr;
+        }
+        return *this;
+    }
+    ofEventListener(const ofEventListener&) = delete;
+    ofEventListener& operator=(const ofEventListener&) = delete;
+    ~ofEventListener() { unsubscribe(); }
+
+    void unsubscribe() {
+        if (remove) remove();
+        remove = nullptr;
+    }
+
+private:
+    std::function<void()> remove;
+};
+
+template<typename T>
+class ofEvent {
+public:
+    ofEvent() : state(std::make_shared<State>()) {}
+    ofEvent(const ofEvent&) = delete;
+    ofEvent& operator=(const ofEvent&) = delete;
+
+    template<typename Function>
+    ofEventListener newListener(Function function) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        int id = state->nextId++;
+        auto entries = std::make_shared<Entries>(*state->entries);
+        entries->push_back(Entry{id, std::function<void(T&)>(function)});
+        state->entries = entries;
+
+        std::weak_ptr<State> weak = state;
+        return ofEventListener([weak, id] {
+            auto state = weak.lock();
+            if (!state) return;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto entries = std::make_shared<Entries>(*state->entries);
+            entries->erase(std::remove_if(entries->begin(), entries->end(), [id](const Entry& entry) { return entry.id == id; }), entries->end());
+            state->entries = entries;
+        });
+    }
+
+    void notify(T& value) {
+        // Listeners are called on a snapshot, without the lock, so they may add and remove listeners
+        std::shared_ptr<const Entries> entries;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            entries = state->entries;
+        }
+        for (auto& entry : *entries) {
+            entry.function(value);
+        }
+    }
+
+private:
+    struct Entry {
+        int id;
+        std::function<void(T&)> function;
+    };
+    typedef std::vector<Entry> Entries;
+    struct State {
+        std::mutex mutex;
+        std::shared_ptr<const Entries> entries = std::make_shared<Entries>();
+        int nextId = 0;
+    };
+    std::shared_ptr<State> state;
+};
+
+template<typename T, typename Value>
+void ofNotifyEvent(ofEvent<T>& event, Value& value) {
+    event.notify(value);
+}
+
+// Serial ports: none. setup() fails, so the addon falls back to its other transports.
+class ofSerialDeviceInfo {
+public:
+    string getDevicePath() const { return devicePath; }
+    string getDeviceName() const { return deviceName; }
+    int getDeviceID() const { return deviceID; }
+
+    string devicePath;
+    string deviceName;
+    int deviceID = 0;
+};
+
+class ofSerial {
+public:
+    bool setup(const string&, int) { return false; }
+    bool setup(int, int) { return false; }
+    bool isInitialized() const { return false; }
+    void close() {}
+    int available() { return 0; }
+    int readByte() { return -1; }
+    long readBytes(uint8_t*, size_t) { return 0; }
+    long writeBytes(const uint8_t*, size_t) { return -1; }
+    bool writeByte(uint8_t) { return false; }
+    void flush(bool = true, bool = true) {}
+    void listDevices() {}
+    vector<ofSerialDeviceInfo> getDeviceList() { return vector<ofSerialDeviceInfo>(); }
+};
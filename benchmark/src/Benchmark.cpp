@@ -0,0 +1,523 @@
+#include "Benchmark.h"
+
+// Doesn't need Arduino or openFrameworks. It measures the framing on in-memory transports.
+
+/*
+Benchmark of the framing layer: encode (sendPacket), decode (update), checksum, unpack and event dispatch,
+of servicing many ports (ptys stand in for serial ports) from one thread, and of the latency of control
+packets behind bulk transfers on a slow link, with and without send priorities.
+Each measurement runs over several payload sizes, escape densities and corruption rates.
+The payloads come from a fixed seed, so the results are comparable between releases.
+Results are printed and saved as JSON (bench_results.json, or the path given on the command line).
+*/
+
+namespace {
+    // Transport that discards everything written to it
+    class NullTransport : public ofxBinaryTransport {
+    public:
+        bool isOpen() const override { return true; }
+        void close() override {}
+        int available() override { return 0; }
+        long readSome(uint8_t*, size_t) override { return 0; }
+        long writeSome(const uint8_t*, size_t length) override { return (long)length; }
+    };
+
+    // Transport that plays back the same bytes every time it is rewound
+    class ReplayTransport final : public ofxBinaryTransport {
+    public:
+        vector<uint8_t> stream;
+        size_t position = 0;
+
+        void rewind() { position = 0; }
+
+        bool isOpen() const override { return true; }
+        void close() override {}
+        int available() override { return (int)(stream.size() - position); }
+        long readSome(uint8_t* buffer, size_t length) override {
+            size_t n = std::min(length, stream.size() - position);
+            memcpy(buffer, stream.data() + position, n);
+            position += n;
+            return (long)n;
+        }
+        long writeSome(const uint8_t*, size_t length) override { return (long)length; }
+    };
+
+    // Loopback end that takes as long to write as a serial link of bytesPerSecond
+    class PacedTransport final : public ofxBinaryTransport {
+    public:
+        PacedTransport(shared_ptr<ofxBinaryLoopbackTransport> inner, size_t bytesPerSecond) : inner(inner), bytesPerSecond(bytesPerSecond) {}
+
+        bool isOpen() const override { return inner->isOpen(); }
+        void close() override { inner->close(); }
+        int available() override { return inner->available(); }
+        long readSome(uint8_t* buffer, size_t length) override { return inner->readSome(buffer, length); }
+        long writeSome(const uint8_t* data, size_t length) override {
+            std::this_thread::sleep_for(std::chrono::microseconds(length * 1000000 / bytesPerSecond));
+            return inner->writeSome(data, length);
+        }
+
+    private:
+        shared_ptr<ofxBinaryLoopbackTransport> inner;
+        size_t bytesPerSecond;
+    };
+
+    // Run func repeatedly until at least minSeconds have passed.
+    // Returns the elapsed time and the number of calls.
+    template<typename Func>
+    double measure(Func func, double minSeconds, uint64_t& calls) {
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        calls = 0;
+        uint64_t batch = 1;
+        while (elapsed < minSeconds) {
+            for (uint64_t i = 0; i < batch; ++i) func();
+            calls += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return elapsed;
+    }
+
+    // Decoder specialized for the replay: fixed Fletcher-16 and no virtual calls into the transport
+    typedef ofxBasicBinaryCommunicator<MAX_PACKET_SIZE, ofxBinaryFletcher16, ReplayTransport> SpecializedCommunicator;
+
+    // Keep results alive so the compiler can't drop the work
+    volatile uint32_t sink;
+
+    // Make the compiler assume the memory at pointer is read, so copies into it are kept
+#if defined(__GNUC__) || defined(__clang__)
+    inline void escape(const void* pointer) {
+        asm volatile("" : : "r"(pointer) : "memory");
+    }
+#else
+    volatile const void* escapedPointer;
+    inline void escape(const void* pointer) {
+        escapedPointer = pointer;
+    }
+#endif
+
+    string escapeJson(const string& text) {
+        string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Handlers for topics 0..LastId, either as onReceived listeners or with subscribe()
+    template<uint8_t LastId>
+    void addDispatchHandlers(ofxBinaryCommunicator& communicator, vector<ofEventListener>& listeners, bool useSubscribe) {
+        typedef BenchTopicData<LastId> Data;
+        if (useSubscribe) {
+            communicator.subscribe<Data>([](const Data& data) { sink = data.x; });
+        }
+        else {
+            listeners.push_back(communicator.onReceived.newListener([](const ofxBinaryPacket& packet) {
+                Data data;
+                if (packet.unpack(data)) sink = data.x;
+            }));
+        }
+        if constexpr (LastId > 0) addDispatchHandlers<LastId - 1>(communicator, listeners, useSubscribe);
+    }
+}
+
+string BenchResult::toJson() const {
+    std::ostringstream json;
+    json << "{\"name\": \"" << escapeJson(name) << "\""
+        << ", \"payloadSize\": " << payloadSize
+        << ", \"escapeDensity\": " << escapeDensity
+        << ", \"corruptionRate\": " << corruptionRate
+        << ", \"packets\": " << packets
+        << ", \"errors\": " << errors
+        << ", \"seconds\": " << seconds
+        << ", \"MBps\": " << (seconds > 0 ? bytes / seconds / 1e6 : 0)
+        << ", \"packetsPerSec\": " << (seconds > 0 ? packets / seconds : 0)
+        << ", \"nsPerPacket\": " << (packets > 0 ? seconds * 1e9 / packets : 0);
+    if (!latencies.empty()) {
+        json << ", \"p50Micros\": " << getLatencyMicros(0.5)
+            << ", \"p99Micros\": " << getLatencyMicros(0.99)
+            << ", \"maxMicros\": " << getLatencyMicros(1);
+    }
+    json << "}";
+    return json.str();
+}
+
+double BenchResult::getLatencyMicros(double p) const {
+    if (latencies.empty()) return 0;
+    vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))] * 1e6;
+}
+
+bool Benchmark::run(const string& resultsPath) {
+    const uint32_t seed = 771;
+    randomEngine.seed(seed);
+    results.clear();
+
+    for (auto size : getPayloadSizes()) {
+        for (auto density : getEscapeDensities()) {
+            addResult(benchEncode(size, density));
+            for (auto corruption : getCorruptionRates()) {
+                addResult(benchDecode<ofxBinaryCommunicator>("decode", size, density, corruption));
+            }
+            addResult(benchDecode<SpecializedCommunicator>("decode specialized", size, density, 0));
+        }
+        addResult(benchChecksum(size, ofxBinaryChecksumType::Fletcher16));
+        addResult(benchChecksum(size, ofxBinaryChecksumType::CRC16));
+        addResult(benchChecksum(size, ofxBinaryChecksumType::CRC32C));
+    }
+
+    addResult(benchUnpack<BenchSmallData>("unpack BenchSmallData"));
+    addResult(benchUnpack<OscLikeMessage>("unpack OscLikeMessage"));
+    addResult(benchUnpack<DeviceInfoResponse>("unpack DeviceInfoResponse"));
+    addResult(benchView<BenchSmallData>("view BenchSmallData"));
+    addResult(benchView<OscLikeMessage>("view OscLikeMessage"));
+
+    addResult(benchDispatch(1, false));
+    addResult(benchDispatch(10, false));
+    addResult(benchDispatch(1, true));
+    addResult(benchDispatch(10, true));
+
+#if !defined(_WIN32)
+    for (int numPorts : {10, 100}) {
+        addResult(benchPorts(numPorts, 4, false));
+        addResult(benchPorts(numPorts, 4, true));
+    }
+#endif
+
+    addResult(benchPriority(false));
+    addResult(benchPriority(true));
+
+    std::ofstream file(resultsPath);
+    file << "{\n  \"maxPacketSize\": " << MAX_PACKET_SIZE << ",\n  \"seed\": " << seed << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        file << "    " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    if (!file) {
+        ofLogError() << "Can't write " << resultsPath;
+        return false;
+    }
+    ofLogNotice() << "Saved " << resultsPath;
+    return true;
+}
+
+vector<size_t> Benchmark::getPayloadSizes() const {
+    // 0, 1, 2, 4 ... MAX_PACKET_SIZE
+    vector<size_t> sizes = {0};
+    for (size_t size = 1; size < MAX_PACKET_SIZE; size *= 2) {
+        sizes.push_back(size);
+    }
+    sizes.push_back(MAX_PACKET_SIZE);
+    return sizes;
+}
+
+vector<float> Benchmark::getEscapeDensities() const {
+    return {0.0f, 0.01f, 0.1f, 0.5f, 1.0f};
+}
+
+vector<float> Benchmark::getCorruptionRates() const {
+    return {0.0f, 0.001f, 0.01f};
+}
+
+vector<uint8_t> Benchmark::makePayload(size_t size, float escapeDensity) {
+    std::uniform_real_distribution<float> chance(0, 1);
+    vector<uint8_t> payload(size);
+    for (auto& byte : payload) {
+        if (chance(randomEngine) < escapeDensity) {
+            byte = randomEngine() % 2 ? PacketHeader : PacketEscape;
+        }
+        else {
+            do {
+                byte = randomEngine() & 0xFF;
+            } while (byte == PacketHeader || byte == PacketEscape);
+        }
+    }
+    return payload;
+}
+
+void Benchmark::addResult(const BenchResult& result) {
+    // Measurements that couldn't run return a result without a name
+    if (result.name.empty()) return;
+    results.push_back(result.toJson());
+    ofLogNotice() << result.name << " size:" << result.payloadSize
+        << " escape:" << result.escapeDensity << " corruption:" << result.corruptionRate
+        << " " << (result.packets > 0 ? result.seconds * 1e9 / result.packets : 0) << " ns/packet";
+    if (!result.latencies.empty()) {
+        ofLogNotice() << "  latency p50:" << result.getLatencyMicros(0.5) << " p99:" << result.getLatencyMicros(0.99)
+            << " max:" << result.getLatencyMicros(1) << " us";
+    }
+}
+
+// sendPacket over a transport that discards the bytes
+BenchResult Benchmark::benchEncode(size_t size, float escapeDensity) {
+    auto payload = makePayload(size, escapeDensity);
+    ofxBinaryCommunicator communicator;
+    communicator.setup(make_shared<NullTransport>());
+    ofxBinaryPacket packet(1, size, payload.data());
+
+    BenchResult result;
+    result.name = "encode";
+    result.payloadSize = size;
+    result.escapeDensity = escapeDensity;
+    result.seconds = measure([&] { communicator.sendPacket(packet); }, minSeconds, result.packets);
+    result.bytes = result.packets * size;
+    return result;
+}
+
+// update() over a prebuilt stream of frames, optionally corrupted.
+// Communicator is ofxBinaryCommunicator or an ofxBasicBinaryCommunicator over ReplayTransport.
+template<typename Communicator>
+BenchResult Benchmark::benchDecode(const string& name, size_t size, float escapeDensity, float corruptionRate) {
+    auto replay = make_shared<ReplayTransport>();
+
+    // About 64KB of frames per pass
+    size_t framesPerPass = std::max<size_t>(1, 65536 / (size + Communicator::MaxFrameHeaderSize));
+    vector<uint8_t> frame;
+    for (size_t i = 0; i < framesPerPass; ++i) {
+        auto payload = makePayload(size, escapeDensity);
+        frame.resize(Communicator::getMaxFrameSize(size));
+        frame.resize(Communicator::encodeFrame(ofxBinaryPacket(1, size, payload.data()), frame.data()));
+        replay->stream.insert(replay->stream.end(), frame.begin(), frame.end());
+    }
+
+    std::uniform_real_distribution<float> chance(0, 1);
+    for (auto& byte : replay->stream) {
+        if (chance(randomEngine) < corruptionRate) byte = randomEngine() & 0xFF;
+    }
+
+    Communicator communicator;
+    communicator.setup(replay);
+    uint64_t received = 0;
+    uint64_t errors = 0;
+    ofEventListener receivedListener = communicator.onReceived.newListener([&](const ofxBinaryPacket&) {
+        received++;
+    });
+    ofEventListener errorListener = communicator.onError.newListener([&](ofxBinaryCommunicator::ErrorType&) {
+        errors++;
+    });
+
+    uint64_t passes;
+    BenchResult result;
+    result.name = name;
+    result.payloadSize = size;
+    result.escapeDensity = escapeDensity;
+    result.corruptionRate = corruptionRate;
+    result.seconds = measure([&] {
+        replay->rewind();
+        communicator.update();
+    }, minSeconds, passes);
+    result.packets = received;
+    result.errors = errors;
+    result.bytes = received * size;
+    return result;
+}
+
+BenchResult Benchmark::benchChecksum(size_t size, ofxBinaryChecksumType type) {
+    auto payload = makePayload(size, 0);
+    const char* names[] = {"checksum Fletcher16", "checksum CRC16", "checksum CRC32C"};
+
+    BenchResult result;
+    result.name = names[(int)type];
+    result.payloadSize = size;
+    result.seconds = measure([&] {
+        sink = ofxBinaryCommunicator::calculateChecksum(payload.data(), size, type);
+    }, minSeconds, result.packets);
+    result.bytes = result.packets * size;
+    return result;
+}
+
+template<typename T>
+BenchResult Benchmark::benchUnpack(const string& name) {
+    auto payload = makePayload(sizeof(T), 0);
+    ofxBinaryPacket packet(T::topicId, sizeof(T), payload.data());
+    T out;
+
+    BenchResult result;
+    result.name = name;
+    result.payloadSize = sizeof(T);
+    result.seconds = measure([&] {
+        sink = packet.unpack(out);
+        escape(&out);
+    }, minSeconds, result.packets);
+    result.bytes = result.packets * sizeof(T);
+    return result;
+}
+
+// view() reads the payload in place, so only the fields the handler touches are read
+template<typename T>
+BenchResult Benchmark::benchView(const string& name) {
+    auto payload = makePayload(sizeof(T), 0);
+    ofxBinaryPacket packet(T::topicId, sizeof(T), payload.data());
+
+    BenchResult result;
+    result.name = name;
+    result.payloadSize = sizeof(T);
+    result.seconds = measure([&] {
+        const T* data = packet.view<T>();
+        escape(data);
+    }, minSeconds, result.packets);
+    result.bytes = result.packets * sizeof(T);
+    return result;
+}
+
+// Cost of handing a received packet to the code that wants it, with handlers for 1 or 10 topics.
+// onReceived calls every listener and each one checks the topicId; subscribe() looks the handler up by topicId.
+// Runs update() over a replay of small frames, so it includes their decoding: compare the results
+// with each other, or subtract "decode" at the same payload size.
+BenchResult Benchmark::benchDispatch(int numTopics, bool useSubscribe) {
+    ofxBinaryCommunicator communicator;
+    vector<ofEventListener> listeners;
+    if (numTopics == 1) addDispatchHandlers<0>(communicator, listeners, useSubscribe);
+    else addDispatchHandlers<9>(communicator, listeners, useSubscribe);
+
+    BenchTopicData<0> data;
+    data.timestamp = 0;
+    data.x = 1;
+    data.y = 2;
+    auto replay = make_shared<ReplayTransport>();
+    vector<uint8_t> frame(ofxBinaryCommunicator::getMaxFrameSize(sizeof(data)));
+    frame.resize(ofxBinaryCommunicator::encodeFrame(ofxBinaryPacket(data), frame.data()));
+    while (replay->stream.size() < 65536) {
+        replay->stream.insert(replay->stream.end(), frame.begin(), frame.end());
+    }
+    communicator.setup(replay);
+
+    uint64_t received = 0;
+    ofEventListener counter = communicator.onReceived.newListener([&](const ofxBinaryPacket&) {
+        received++;
+    });
+
+    uint64_t passes;
+    BenchResult result;
+    result.name = string(useSubscribe ? "dispatch subscribe " : "dispatch onReceived ") + ofToString(numTopics) + " topics";
+    result.payloadSize = sizeof(data);
+    result.seconds = measure([&] {
+        replay->rewind();
+        communicator.update();
+    }, minSeconds, passes);
+    result.packets = received;
+    result.bytes = received * sizeof(data);
+    return result;
+}
+
+#if !defined(_WIN32)
+// numPorts pty pairs of which activePorts send one packet per round. The host side is serviced either
+// by calling update() on every communicator or with ofxBinaryCommunicatorHub, which only decodes the
+// readable ports. Counts a round trip from write to delivery, so it includes the kernel's pty latency.
+BenchResult Benchmark::benchPorts(int numPorts, int activePorts, bool useHub) {
+    vector<unique_ptr<ofxBinaryCommunicator>> hosts;
+    vector<unique_ptr<ofxBinaryCommunicator>> devices;
+    ofxBinaryCommunicatorHub hub;
+    uint64_t received = 0;
+    vector<ofEventListener> listeners;
+    for (int i = 0; i < numPorts; ++i) {
+        auto pair = ofxBinaryPtyTransport::createPair();
+        if (!pair.first) break;
+        hosts.emplace_back(new ofxBinaryCommunicator());
+        hosts.back()->setup(pair.first);
+        listeners.push_back(hosts.back()->onReceived.newListener([&](const ofxBinaryPacket&) {
+            received++;
+        }));
+        devices.emplace_back(new ofxBinaryCommunicator());
+        devices.back()->setup(pair.second);
+        if (useHub) hub.add(*hosts.back());
+    }
+    if (hosts.size() < (size_t)activePorts) {
+        ofLogError() << "Opened " << hosts.size() << " of " << numPorts << " ptys, need " << activePorts << " active ports";
+        return BenchResult();
+    }
+
+    BenchSmallData data;
+    data.timestamp = 0;
+    data.x = 1;
+    data.y = 2;
+
+    uint64_t rounds;
+    BenchResult result;
+    result.name = string(useHub ? "ports hub " : "ports update all ") + ofToString(hosts.size()) + "/" + ofToString(activePorts);
+    result.payloadSize = sizeof(data);
+    result.seconds = measure([&] {
+        uint64_t expected = received;
+        for (int i = 0; i < activePorts; ++i) {
+            devices[i * hosts.size() / activePorts]->send(data);
+            expected++;
+        }
+        while (received < expected) {
+            if (useHub) {
+                hub.poll(1);
+            }
+            else {
+                for (auto& host : hosts) host->update();
+            }
+        }
+    }, minSeconds, rounds);
+    result.packets = received;
+    result.bytes = received * sizeof(data);
+    return result;
+}
+#endif
+
+// Control packets sent every 2 ms while another thread keeps a 1 Mbaud link busy with sendLarge().
+// Measures from send() to delivery on the other end. Without priorities each control packet waits
+// behind the whole send queue; with SendPriority::Control it waits for the write in progress only.
+BenchResult Benchmark::benchPriority(bool usePriorities) {
+    typedef BenchTopicData<1> ControlData;
+    const uint8_t bulkTopicId = 2;
+    const size_t bytesPerSecond = 1000000 / 10;
+
+    auto pair = ofxBinaryLoopbackTransport::createPair();
+    ofxBinaryCommunicator host;
+    ofxBinaryCommunicator device;
+    host.setup(make_shared<PacedTransport>(pair.first, bytesPerSecond));
+    device.setup(pair.second);
+    if (usePriorities) {
+        host.setSendPriority<ControlData>(ofxBinaryCommunicator::SendPriority::Control);
+        host.setSendPriority(bulkTopicId, ofxBinaryCommunicator::SendPriority::Bulk);
+    }
+    host.startSendThread(64);
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedSeconds = [start] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    BenchResult result;
+    result.name = usePriorities ? "control latency priority" : "control latency fifo";
+    result.payloadSize = sizeof(ControlData);
+    device.subscribe<ControlData>([&](const ControlData& data) {
+        result.latencies.push_back(elapsedSeconds() - data.timestamp * 1e-6);
+    });
+
+    std::atomic<bool> running(true);
+    std::thread bulk([&] {
+        vector<uint8_t> payload = makePayload(4096, 0);
+        while (running) host.sendLarge(bulkTopicId, payload.data(), payload.size());
+    });
+
+    // Let the bulk transfer fill the queue first
+    ofSleepMillis(100);
+    const int count = 100;
+    for (int i = 0; i < count; ++i) {
+        ControlData data;
+        data.timestamp = (int32_t)(elapsedSeconds() * 1e6);
+        data.x = i;
+        data.y = 0;
+        host.send(data);
+        ofSleepMillis(2);
+        device.update();
+    }
+    // Keep the link busy until the last control packet is through
+    double deadline = elapsedSeconds() + 5;
+    while (result.latencies.size() < (size_t)count && elapsedSeconds() < deadline) {
+        ofSleepMillis(1);
+        device.update();
+    }
+    running = false;
+    bulk.join();
+    host.stopSendThread();
+    device.update();
+
+    result.packets = result.latencies.size();
+    result.bytes = result.packets * sizeof(ControlData);
+    for (double latency : result.latencies) result.seconds += latency;
+    return result;
+}
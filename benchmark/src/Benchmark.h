@@ -0,0 +1,75 @@
+#pragma once
+
+// Doesn't need Arduino or openFrameworks. It measures the framing on in-memory transports.
+
+#include "ofMain.h"
+#include "ofxBinaryCommunicator.h"
+#include <random>
+
+TOPIC_STRUCT_MAKER(BenchSmallData, 0,
+    int32_t timestamp;
+    int32_t x;
+    int32_t y;
+)
+
+// Same layout under several topicIds, for the dispatch benchmark
+template<uint8_t Id>
+struct BenchTopicData {
+    static const uint8_t topicId = Id;
+    int32_t timestamp;
+    int32_t x;
+    int32_t y;
+};
+
+// Result of one measurement
+struct BenchResult {
+    string name;
+    size_t payloadSize = 0;
+    float escapeDensity = 0;   // ratio of PacketHeader/PacketEscape bytes in the payload
+    float corruptionRate = 0;  // ratio of bytes replaced with random values on the wire
+    uint64_t packets = 0;      // packets processed (sent, decoded, unpacked...)
+    uint64_t bytes = 0;        // payload bytes processed
+    uint64_t errors = 0;       // onError count (decode only)
+    double seconds = 0;
+    vector<double> latencies;  // per packet, in seconds (latency benchmarks only)
+
+    // p in [0, 1], in microseconds
+    double getLatencyMicros(double p) const;
+    // One JSON object
+    string toJson() const;
+};
+
+class Benchmark {
+public:
+    // Runs every measurement and writes the results to resultsPath
+    bool run(const string& resultsPath);
+
+private:
+    // Payload profiles
+    vector<size_t> getPayloadSizes() const;
+    vector<float> getEscapeDensities() const;
+    vector<float> getCorruptionRates() const;
+    vector<uint8_t> makePayload(size_t size, float escapeDensity);
+
+    BenchResult benchEncode(size_t size, float escapeDensity);
+    template<typename Communicator>
+    BenchResult benchDecode(const string& name, size_t size, float escapeDensity, float corruptionRate);
+    BenchResult benchChecksum(size_t size, ofxBinaryChecksumType type);
+    template<typename T>
+    BenchResult benchUnpack(const string& name);
+    template<typename T>
+    BenchResult benchView(const string& name);
+    BenchResult benchDispatch(int numTopics, bool useSubscribe);
+#if !defined(_WIN32)
+    BenchResult benchPorts(int numPorts, int activePorts, bool useHub);
+#endif
+    BenchResult benchPriority(bool usePriorities);
+
+    void addResult(const BenchResult& result);
+
+    std::mt19937 randomEngine;
+    vector<string> results; // JSON objects
+
+    // Minimum time spent on each measurement
+    double minSeconds = 0.2;
+};
@@ -0,0 +1,269 @@
+#include "ofMain.h"
+#include "ofxBinaryCommunicator.h"
+#include <random>
+
+/*
+Checks that the chunked decoder (processIncomingBytes) gives the same packets and errors, in the
+same order, as the byte-at-a-time state machine it replaced. The reference below is that state
+machine as it was, with Fletcher-16, except that it delivers frames with a zero-length payload
+(the old one waited for a data byte that never came).
+
+Random streams of frames, garbage and corrupted bytes are written into a loopback transport in
+random chunk sizes, with update() after each chunk. Topic ids and corrupted bytes stay below the
+reserved topics, so the communicator hands every valid frame to onReceived.
+Exits with 0 when every stream matches.
+*/
+
+namespace {
+    typedef ofxBasicBinaryCommunicator<MAX_PACKET_SIZE, ofxBinaryFletcher16> Communicator;
+    typedef Communicator::ErrorType ErrorType;
+
+    // Largest topicId and corrupted byte value: below the reserved topics
+    const uint8_t MaxValue = 240;
+
+    // A received packet or an error
+    struct Event {
+        bool isError;
+        ErrorType error;
+        uint8_t topicId;
+        vector<uint8_t> data;
+
+        bool operator==(const Event& other) const {
+            if (isError != other.isError) return false;
+            if (isError) return error == other.error;
+            return topicId == other.topicId && data == other.data;
+        }
+    };
+
+    string toString(const Event& event) {
+        if (event.isError) return "error " + Communicator::ErrorToString(event.error);
+        return "packet topic:" + ofToString((int)event.topicId) + " length:" + ofToString(event.data.size());
+    }
+
+    uint16_t fletcher16(const uint8_t* data, uint16_t length) {
+        uint8_t sum1 = 0xff;
+        uint8_t sum2 = 0xff;
+        while (length--) {
+            sum1 += *data++;
+            sum2 += sum1;
+        }
+        return (sum2 << 8) | sum1;
+    }
+
+    // The previous decoder, one byte at a time
+    class ReferenceDecoder {
+    public:
+        vector<Event> events;
+
+        void processIncomingByte(uint8_t byte) {
+            switch (state) {
+                case ReceiveState::WaitingForHeader:
+                    if (byte == PacketHeader) {
+                        state = ReceiveState::ReceivingChecksum;
+                        receivedChecksum = 0;
+                        receivedLength = 0;
+                    }
+                    break;
+
+                case ReceiveState::ReceivingChecksum:
+                    receivedChecksum = (receivedChecksum << 8) | byte;
+                    if (receivedLength == 1) {
+                        state = ReceiveState::ReceivingTopicId;
+                        topicId = 0;
+                        receivedLength = 0;
+                    } else {
+                        receivedLength++;
+                    }
+                    break;
+
+                case ReceiveState::ReceivingTopicId:
+                    topicId = byte;
+                    state = ReceiveState::ReceivingLength;
+                    packetLength = 0;
+                    receivedLength = 0;
+                    break;
+
+                case ReceiveState::ReceivingLength:
+                    packetLength = (packetLength << 8) | byte;
+                    if (receivedLength == 1) {
+                        state = ReceiveState::ReceivingData;
+                        receivedLength = 0;
+                        if (packetLength > MAX_PACKET_SIZE) {
+                            notifyError(ErrorType::BufferOverflow);
+                            state = ReceiveState::WaitingForHeader;
+                        }
+                        else if (packetLength == 0) {
+                            // The one intended change: no payload follows
+                            packetReceived();
+                            state = ReceiveState::WaitingForHeader;
+                        }
+                    } else {
+                        receivedLength++;
+                    }
+                    break;
+
+                case ReceiveState::ReceivingData:
+                    if (byte == PacketEscape) {
+                        state = ReceiveState::ReceivingEscape;
+                    } else if (byte == PacketHeader) {
+                        notifyError(ErrorType::UnexpectedHeader);
+                        state = ReceiveState::ReceivingChecksum;
+                        receivedChecksum = 0;
+                        receivedLength = 0;
+                    } else {
+                        receivedData[receivedLength++] = byte;
+                        if (receivedLength == packetLength) {
+                            packetReceived();
+                            state = ReceiveState::WaitingForHeader;
+                        } else if (receivedLength > packetLength) {
+                            notifyError(ErrorType::BufferOverflow);
+                            state = ReceiveState::WaitingForHeader;
+                        }
+                    }
+                    break;
+
+                case ReceiveState::ReceivingEscape:
+                    if (byte == PacketHeader || byte == PacketEscape) {
+                        receivedData[receivedLength++] = byte;
+                        if (receivedLength == packetLength) {
+                            packetReceived();
+                            state = ReceiveState::WaitingForHeader;
+                        } else if (receivedLength > packetLength) {
+                            notifyError(ErrorType::BufferOverflow);
+                            state = ReceiveState::WaitingForHeader;
+                        } else {
+                            state = ReceiveState::ReceivingData;
+                        }
+                    } else {
+                        notifyError(ErrorType::UnknownError);
+                        state = ReceiveState::WaitingForHeader;
+                    }
+                    break;
+            }
+        }
+
+    private:
+        enum class ReceiveState {
+            WaitingForHeader,
+            ReceivingChecksum,
+            ReceivingTopicId,
+            ReceivingLength,
+            ReceivingData,
+            ReceivingEscape
+        };
+
+        void packetReceived() {
+            if (fletcher16(receivedData, packetLength) == receivedChecksum) {
+                events.push_back(Event{false, ErrorType::UnknownError, topicId, vector<uint8_t>(receivedData, receivedData + receivedLength)});
+            } else {
+                notifyError(ErrorType::ChecksumMismatch);
+            }
+        }
+
+        void notifyError(ErrorType error) {
+            events.push_back(Event{true, error, 0, vector<uint8_t>()});
+        }
+
+        ReceiveState state = ReceiveState::WaitingForHeader;
+        uint8_t receivedData[MAX_PACKET_SIZE];
+        uint16_t receivedChecksum = 0;
+        uint16_t receivedLength = 0;
+        uint16_t packetLength = 0;
+        uint8_t topicId = 0;
+    };
+
+    // The previous encoder: lengths up to 65535, so oversized frames can be sent too
+    void appendFrame(vector<uint8_t>& stream, uint8_t topicId, const vector<uint8_t>& payload) {
+        uint16_t checksum = fletcher16(payload.data(), (uint16_t)payload.size());
+        stream.push_back(PacketHeader);
+        stream.push_back(checksum >> 8);
+        stream.push_back(checksum & 0xFF);
+        stream.push_back(topicId);
+        stream.push_back(payload.size() >> 8);
+        stream.push_back(payload.size() & 0xFF);
+        for (uint8_t byte : payload) {
+            if (byte == PacketHeader || byte == PacketEscape) stream.push_back(PacketEscape);
+            stream.push_back(byte);
+        }
+    }
+
+    // Frames with escapes, oversized and empty payloads and garbage in between,
+    // then corruptionRate of the bytes replaced
+    vector<uint8_t> makeStream(std::mt19937& random, int numFrames, float escapeDensity, float corruptionRate) {
+        std::uniform_int_distribution<int> value(0, MaxValue);
+        std::uniform_real_distribution<float> chance(0, 1);
+        vector<uint8_t> stream;
+        for (int i = 0; i < numFrames; ++i) {
+            if (chance(random) < 0.1f) {
+                int garbage = std::uniform_int_distribution<int>(1, 20)(random);
+                for (int j = 0; j < garbage; ++j) stream.push_back(value(random));
+            }
+            size_t length;
+            float kind = chance(random);
+            if (kind < 0.05f) length = 0;
+            else if (kind < 0.1f) length = std::uniform_int_distribution<size_t>(MAX_PACKET_SIZE + 1, MAX_PACKET_SIZE + 64)(random);
+            else length = std::uniform_int_distribution<size_t>(1, MAX_PACKET_SIZE)(random);
+            vector<uint8_t> payload(length);
+            for (auto& byte : payload) {
+                if (chance(random) < escapeDensity) byte = chance(random) < 0.5f ? PacketHeader : PacketEscape;
+                else byte = value(random);
+            }
+            appendFrame(stream, value(random), payload);
+        }
+        for (auto& byte : stream) {
+            if (chance(random) < corruptionRate) byte = value(random);
+        }
+        return stream;
+    }
+
+    // Runs one stream through both decoders. Returns false and prints the first difference.
+    bool check(std::mt19937& random, const string& name, float escapeDensity, float corruptionRate, size_t maxChunk) {
+        vector<uint8_t> stream = makeStream(random, 2000, escapeDensity, corruptionRate);
+
+        ReferenceDecoder reference;
+        for (uint8_t byte : stream) reference.processIncomingByte(byte);
+
+        vector<Event> events;
+        Communicator communicator;
+        ofEventListener receivedListener = communicator.onReceived.newListener([&](const ofxBinaryPacket& packet) {
+            events.push_back(Event{false, ErrorType::UnknownError, packet.topicId, vector<uint8_t>(packet.data, packet.data + packet.length)});
+        });
+        ofEventListener errorListener = communicator.onError.newListener([&](ErrorType& error) {
+            events.push_back(Event{true, error, 0, vector<uint8_t>()});
+        });
+        auto ends = ofxBinaryLoopbackTransport::createPair();
+        communicator.setup(ends.first);
+        std::uniform_int_distribution<size_t> chunkSize(1, maxChunk);
+        for (size_t position = 0; position < stream.size();) {
+            size_t n = std::min(chunkSize(random), stream.size() - position);
+            ends.second->writeSome(stream.data() + position, n);
+            communicator.update();
+            position += n;
+        }
+
+        size_t common = std::min(events.size(), reference.events.size());
+        size_t mismatch = std::mismatch(events.begin(), events.begin() + common, reference.events.begin()).first - events.begin();
+        if (mismatch == common && events.size() == reference.events.size()) {
+            ofLogNotice() << "ok   " << name << ": " << events.size() << " events";
+            return true;
+        }
+        ofLogError() << "FAIL " << name << ": event " << mismatch << " of " << events.size() << " (reference " << reference.events.size() << ")";
+        if (mismatch < events.size()) ofLogError() << "  decoder:   " << toString(events[mismatch]);
+        if (mismatch < reference.events.size()) ofLogError() << "  reference: " << toString(reference.events[mismatch]);
+        return false;
+    }
+}
+
+int main() {
+    std::mt19937 random(771);
+    bool passed = true;
+    for (float escapeDensity : {0.0f, 0.01f, 0.5f}) {
+        for (float corruptionRate : {0.0f, 0.001f, 0.01f, 0.05f}) {
+            for (size_t maxChunk : {1, 7, 64, 4096}) {
+                string name = "escape:" + ofToString(escapeDensity) + " corruption:" + ofToString(corruptionRate) + " chunk:" + ofToString(maxChunk);
+                passed = check(random, name, escapeDensity, corruptionRate, maxChunk) && passed;
+            }
+        }
+    }
+    return passed ? 0 : 1;
+}
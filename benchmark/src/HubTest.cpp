@@ -0,0 +1,78 @@
+#include "ofMain.h"
+#include "ofxBinaryCommunicator.h"
+
+/*
+Checks that ofxBinaryCommunicatorHub keeps blocking in poll() after a port that hung up is removed,
+and that a port added afterwards (which may get the same descriptor number) is still polled.
+Exits with 0 when every check passes.
+*/
+
+namespace {
+    bool passed = true;
+
+    void expect(bool condition, const string& what) {
+        if (condition) {
+            ofLogNotice() << "ok   " << what;
+        }
+        else {
+            ofLogError() << "FAIL " << what;
+            passed = false;
+        }
+    }
+
+    // Milliseconds poll(timeoutMillis) took
+    uint64_t timePoll(ofxBinaryCommunicatorHub& hub, int timeoutMillis) {
+        uint64_t start = ofGetElapsedTimeMillis();
+        hub.poll(timeoutMillis);
+        return ofGetElapsedTimeMillis() - start;
+    }
+}
+
+int main() {
+#if defined(_WIN32)
+    ofLogNotice() << "skipped: no ptys";
+    return 0;
+#else
+    ofxBinaryCommunicatorHub hub;
+
+    auto first = ofxBinaryPtyTransport::createPair();
+    if (!first.first || !first.second) {
+        ofLogError() << "Can't open a pty";
+        return 1;
+    }
+    ofxBinaryCommunicator hungUp;
+    hungUp.setup(first.first);
+    expect(hub.add(hungUp) >= 0, "add a pty port");
+
+    // The other end goes away: the hub notices, and stops polling the port
+    first.second->close();
+    for (int i = 0; i < 10 && hungUp.getTransport()->isOpen(); ++i) {
+        hub.poll(10);
+    }
+    expect(!hungUp.getTransport()->isOpen(), "the port closes when the other end hangs up");
+
+    hub.remove(hungUp);
+    expect(hub.size() == 0, "remove the hung up port");
+    expect(timePoll(hub, 200) >= 150, "poll(200) still blocks after the hung up port is removed");
+
+    // A new port, most likely on the descriptor number the closed one had
+    auto second = ofxBinaryPtyTransport::createPair();
+    ofxBinaryCommunicator host, device;
+    host.setup(second.first);
+    device.setup(second.second);
+    expect(hub.add(host) >= 0, "add another pty port");
+    int received = 0;
+    ofEventListener listener = host.onReceived.newListener([&](const ofxBinaryPacket&) {
+        received++;
+    });
+    uint8_t value = 1;
+    device.sendPacket(ofxBinaryPacket(1, 1, &value));
+    for (int i = 0; i < 10 && received == 0; ++i) {
+        hub.poll(100);
+    }
+    expect(received == 1, "the new port is polled");
+    expect(timePoll(hub, 200) >= 150, "poll(200) blocks while the new port is idle");
+
+    return passed ? 0 : 1;
+#endif
+}
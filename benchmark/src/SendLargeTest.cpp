@@ -0,0 +1,77 @@
+#include "ofMain.h"
+#include "ofxBinaryCommunicator.h"
+
+/*
+Checks sendLarge() on links with a small MaxPacket: below or at sizeof(FragmentHeader) it refuses
+payloads that need fragments, just above it the fragments carry a byte or two each and an
+ofxBinaryCommunicator on the other end still reassembles the payload.
+Exits with 0 when every check passes.
+*/
+
+namespace {
+    bool passed = true;
+
+    void expect(bool condition, const string& what) {
+        if (condition) {
+            ofLogNotice() << "ok   " << what;
+        }
+        else {
+            ofLogError() << "FAIL " << what;
+            passed = false;
+        }
+    }
+
+    // Sends a payload of length bytes from a link of MaxPacket to a default one.
+    // Returns what sendLarge() returned; received is the payload that arrived, if any.
+    template<size_t MaxPacket>
+    bool sendLarge(size_t length, vector<uint8_t>& received) {
+        auto ends = ofxBinaryLoopbackTransport::createPair();
+        ofxBasicBinaryCommunicator<MaxPacket> sender;
+        ofxBinaryCommunicator receiver;
+        sender.setup(ends.first);
+        receiver.setup(ends.second);
+        ofEventListener listener = receiver.onReceived.newListener([&](const ofxBinaryPacket& packet) {
+            if (packet.topicId == 1) received.assign(packet.data, packet.data + packet.length);
+        });
+
+        vector<uint8_t> payload(length);
+        for (size_t i = 0; i < length; ++i) payload[i] = (uint8_t)(i * 7);
+        bool sent = sender.sendLarge(1, payload.data(), payload.size());
+        receiver.update();
+        return sent;
+    }
+
+    template<size_t MaxPacket>
+    void expectRefused(size_t length) {
+        vector<uint8_t> received;
+        string name = "MaxPacket " + ofToString(MaxPacket) + ", " + ofToString(length) + " bytes";
+        expect(!sendLarge<MaxPacket>(length, received), name + ": refused");
+        expect(received.empty(), name + ": nothing arrives");
+    }
+
+    template<size_t MaxPacket>
+    void expectDelivered(size_t length) {
+        vector<uint8_t> received;
+        string name = "MaxPacket " + ofToString(MaxPacket) + ", " + ofToString(length) + " bytes";
+        expect(sendLarge<MaxPacket>(length, received), name + ": sent");
+        bool intact = received.size() == length;
+        for (size_t i = 0; intact && i < length; ++i) intact = received[i] == (uint8_t)(i * 7);
+        expect(intact, name + ": reassembled");
+    }
+}
+
+int main() {
+    const size_t headerSize = sizeof(FragmentHeader);
+
+    // Fits in one frame: sent as is, whatever the size
+    expectDelivered<4>(4);
+    // No room for data next to the header
+    expectRefused<4>(20);
+    expectRefused<headerSize>(20);
+    // One and two bytes of data per fragment
+    expectDelivered<headerSize + 1>(20);
+    expectDelivered<headerSize + 2>(301);
+    expectDelivered<64>(1000);
+
+    return passed ? 0 : 1;
+}
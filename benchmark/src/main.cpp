@@ -0,0 +1,7 @@
+#include "Benchmark.h"
+
+// Usage: ofxBinaryCommunicatorBenchmark [results.json]
+int main(int argc, char* argv[]) {
+	string resultsPath = argc > 1 ? argv[1] : "bench_results.json";
+	return Benchmark().run(resultsPath) ? 0 : 1;
+}
@@ -5,7 +5,7 @@
 /*
 This is a sample that communicates between structures called OscLikeMessage.
 Like Osc, you can specify an address and send values ​​such as Int32 or float. However, there are some types, such as strings, that cannot be sent. This is because the OscLikeMessage structure is fixed length.
-As you can see from the definition of OscLikeMessage, it itself becomes a relatively large binary (an instance is 192 bytes), so in order to achieve efficient sending and receiving, it is recommended to define a small structure like in the basic example.
+As you can see from the definition of OscLikeMessage, it itself becomes a relatively large binary (an instance is 192 bytes). sendCompact() sends only the address and the arguments in use, and unpack() reads both forms. For the most efficient sending and receiving, define a small structure like in the basic example.
 */
 
 void ofApp::setup() {
@@ -49,7 +49,7 @@ void ofApp::mouseMoved(int x, int y) {
     msg.setAddress("/input/mouse");
     msg.addInt32Arg(x);
     msg.addInt32Arg(y);
-    communicator.send(msg);
+    communicator.sendCompact(msg);
     
     ofLogNotice() << "Sent mouse data - X: " << x << ", Y: " << y;
 }
@@ -58,7 +58,7 @@ void ofApp::keyPressed(int key) {
     OscLikeMessage msg;
     msg.setAddress("/input/key");
     msg.addCharArg(key);
-    communicator.send(msg);
+    communicator.sendCompact(msg);
     
     ofLogNotice() << "Sent key data :" << key;
 }
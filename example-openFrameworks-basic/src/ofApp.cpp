@@ -7,6 +7,9 @@ void ofApp::setup() {
     ofSetFrameRate(60);
     // communicator.setup("COM3", 115200);
     communicator.setup("/dev/cu.usbmodem101", 115200);  // Adjust port name as needed
+    // mouseMoved can fire faster than 115200 baud carries. Only the newest position matters,
+    // so let newer ones replace those that haven't gone out yet.
+    communicator.setCoalescing<SampleMouseData>();
 
     ofAddListener(communicator.onReceived, this, &ofApp::onMessageReceived);
     ofAddListener(communicator.onError, this, &ofApp::onError);
@@ -51,12 +51,12 @@ void loop() {
   // Send sensor data every second
   static unsigned long lastSensorSend = 0;
   if (millis() - lastSensorSend > 1000) {
-    // predefined struct: OscLikeMessage (High overhead)
+    // predefined struct: OscLikeMessage
     OscLikeMessage msg;
     msg.setAddress("/sensor/value"); // Max 32 char
     msg.addInt32Arg(millis());
     msg.addFloatArg(analogRead(A0) / 1024.0);
-    communicator.send(msg);
+    communicator.sendCompact(msg); // 24 bytes on the wire instead of 192
 
     lastSensorSend = millis();
   }
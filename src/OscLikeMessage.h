@@ -307,5 +307,128 @@ TOPIC_STRUCT_MAKER(OscLikeMessage, 250,
         return typestr;
     }
 
+    /**
+     * Compact wire form
+     * address length (1) + address, argument count (1), a 4 bit type code per argument (two per byte),
+     * then only the bytes of the populated arguments: none for bools, 1 for a char, 4 for the others.
+     * A message with one float and a short address takes about 15 bytes instead of 192.
+     * The longest form is smaller than the struct, so a packet of topicId 250 is the struct exactly
+     * when its length is sizeof(OscLikeMessage). packet.unpack(msg) reads both.
+     */
+    static const int MAX_ENCODED_SIZE = 1 + (ADDRESS_SIZE - 1) + 1 + MAX_ARGS / 2 + MAX_ARGS * 4;
+
+    // Writes at most MAX_ENCODED_SIZE bytes to out. Returns the number of bytes written.
+    size_t encode(uint8_t* out) const {
+        size_t size = 0;
+        uint8_t addressLength = 0;
+        while (addressLength < ADDRESS_SIZE - 1 && address[addressLength] != '\0') addressLength++;
+        out[size++] = addressLength;
+        memcpy(out + size, address, addressLength);
+        size += addressLength;
+
+        // Unset slots before the last argument are kept as code 0
+        int count = MAX_ARGS;
+        while (count > 0 && typestr[count - 1] == '\0') count--;
+        out[size++] = (uint8_t)count;
+        uint8_t* codes = out + size;
+        memset(codes, 0, (count + 1) / 2);
+        size += (count + 1) / 2;
+        for (int idx = 0; idx < count; idx++) {
+            uint8_t code = getTypeCode(typestr[idx]);
+            codes[idx / 2] |= (idx % 2 == 0) ? code : (uint8_t)(code << 4);
+            uint8_t length = getArgLength(code);
+            memcpy(out + size, C[idx], length);
+            size += length;
+        }
+        return size;
+    }
+
+    // Replaces this message with an encoded one. Returns false if the data is malformed.
+    bool decode(const uint8_t* data, size_t length) {
+        clear();
+        size_t pos = 0;
+        if (length < 1 || data[0] > ADDRESS_SIZE - 1) return false;
+        uint8_t addressLength = data[pos++];
+        if (pos + addressLength + 1 > length) return false;
+        memcpy(address, data + pos, addressLength);
+        pos += addressLength;
+
+        int count = data[pos++];
+        if (count > MAX_ARGS || pos + (count + 1) / 2 > length) return false;
+        const uint8_t* codes = data + pos;
+        pos += (count + 1) / 2;
+        for (int idx = 0; idx < count; idx++) {
+            uint8_t code = (idx % 2 == 0) ? (codes[idx / 2] & 0x0F) : (codes[idx / 2] >> 4);
+            char type = getTypeChar(code);
+            if (code != 0 && type == '\0') return false;
+            uint8_t argLength = getArgLength(code);
+            if (pos + argLength > length) return false;
+            typestr[idx] = type;
+            memcpy(C[idx], data + pos, argLength);
+            pos += argLength;
+            if (code == 1) i[idx] = 1; // 'T'
+        }
+        return pos == length;
+    }
+
+    // The compact form as a packet, encoded into buffer (MAX_ENCODED_SIZE bytes)
+    ofxBinaryPacket toCompactPacket(uint8_t* buffer) const {
+        return ofxBinaryPacket(topicId, (uint16_t)encode(buffer), buffer);
+    }
+
+    // Either form: the struct or the compact form
+    bool unpackPacket(const ofxBinaryPacket& packet) {
+        if (packet.topicId != topicId) return false;
+        if (packet.length == sizeof(*this)) {
+            memcpy(this, packet.data, sizeof(*this));
+            return true;
+        }
+        return decode(packet.data, packet.length);
+    }
+
+    // Type codes of the compact form. 0 is an unset slot.
+    static uint8_t getTypeCode(char type) {
+        switch (type) {
+            case 'T': return 1;
+            case 'F': return 2;
+            case 'i': return 3;
+            case 'I': return 4;
+            case 'f': return 5;
+            case 'c': return 6;
+            case 'C': return 7;
+            case 'r': return 8;
+            default: return 0;
+        }
+    }
+
+    static char getTypeChar(uint8_t code) {
+        switch (code) {
+            case 1: return 'T';
+            case 2: return 'F';
+            case 3: return 'i';
+            case 4: return 'I';
+            case 5: return 'f';
+            case 6: return 'c';
+            case 7: return 'C';
+            case 8: return 'r';
+            default: return '\0';
+        }
+    }
+
+    static uint8_t getArgLength(uint8_t code) {
+        if (code <= 2) return 0; // unset and bools: the code says it all
+        if (code == 6) return 1; // char
+        return 4;
+    }
+
     OF_VERSION_MAJOR_METHODS
 )
+
+static_assert(OscLikeMessage::MAX_ENCODED_SIZE < sizeof(OscLikeMessage), "the compact form must be shorter than the struct");
+
+// Read both the struct and the compact form, so subscribe<OscLikeMessage>() and packet.unpack(msg) take either.
+// view<OscLikeMessage>() only works for the struct.
+template<>
+inline bool ofxBinaryPacket::unpack<OscLikeMessage>(OscLikeMessage& out, decltype(OscLikeMessage::topicId)*) const {
+    return out.unpackPacket(*this);
+}
@@ -1,217 +1,98 @@
 #include "ofxBinaryCommunicator.h"
 
-// Constructor
-ofxBinaryCommunicator::ofxBinaryCommunicator() : serial(nullptr) {
-    state = ReceiveState::WaitingForHeader;
-}
-
-// Destructor
-ofxBinaryCommunicator::~ofxBinaryCommunicator() {
-    #ifdef OF_VERSION_MAJOR
-    if (serial != nullptr) {
-        delete serial;
-        serial = nullptr;
-    }
-    #endif
-}
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
 
-// Setup method
-#ifdef OF_VERSION_MAJOR
-void ofxBinaryCommunicator::setup(const std::string& portName, int baudRate) {
-    if (serial == nullptr) {
-        serial = new ofSerial();
-    }
-    serial->setup(portName, baudRate);
-    initialized = serial->isInitialized();
-}
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+// Index of the lowest set bit (mask must not be 0)
+static inline unsigned countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
 #else
-void ofxBinaryCommunicator::setup(Stream& serialStream) {
-    serial = &serialStream;
-    initialized = true;
-}
+    return (unsigned)__builtin_ctz(mask);
 #endif
-
-// Update method to process incoming data
-void ofxBinaryCommunicator::update() {
-    #ifdef OF_VERSION_MAJOR
-    if (serial != nullptr && serial->isInitialized()) {
-        while (serial->available() > 0) {
-            uint8_t incomingByte = serial->readByte();
-            processIncomingByte(incomingByte);
-        }
-    }
-    #else
-    while (serial->available() > 0) {
-        uint8_t incomingByte = serial->read();
-        processIncomingByte(incomingByte);
-    }
-    #endif
-}
-
-void ofxBinaryCommunicator::sendPacket(const ofxBinaryPacket& packet) {
-    sendByte(PacketHeader);
-
-    uint16_t checksum = calculateChecksum(packet.data, packet.length);
-    // 2 bytes
-    sendByte(checksum >> 8);
-    sendByte(checksum & 0xFF);
-
-    sendByte(packet.topicId);
-
-    // 2 bytes
-    sendByte(packet.length >> 8);
-    sendByte(packet.length & 0xFF);
-
-    for (uint16_t i = 0; i < packet.length; ++i) {
-        if (packet.data[i] == PacketHeader || packet.data[i] == PacketEscape) {
-            sendByte(PacketEscape);
-        }
-        sendByte(packet.data[i]);
-    }
 }
+#endif
 
-// Process each incoming byte
-void ofxBinaryCommunicator::processIncomingByte(uint8_t byte) {
-    switch (state) {
-        case ReceiveState::WaitingForHeader:
-            if (byte == PacketHeader) {
-                state = ReceiveState::ReceivingChecksum;
-                receivedChecksum = 0;
-                receivedLength = 0;
-            } else {
-                // 無視してゴミbyteを捨てる
-            }
-            break;
-
-        case ReceiveState::ReceivingChecksum:
-            receivedChecksum = (receivedChecksum << 8) | byte;
-            if (receivedLength == 1) {
-                state = ReceiveState::ReceivingTopicId;
-                topicId = 0;
-                receivedLength = 0;
-            } else {
-                receivedLength++;
-            }
-            break;
-
-        case ReceiveState::ReceivingTopicId:
-            topicId = byte;
-            state = ReceiveState::ReceivingLength;
-            packetLength = 0;
-            receivedLength = 0;
-            break;
-
-        case ReceiveState::ReceivingLength:
-            packetLength = (packetLength << 8) | byte;
-            if (receivedLength == 1) {
-                state = ReceiveState::ReceivingData;
-                receivedLength = 0;
-                if (packetLength > MAX_PACKET_SIZE) {
-                    notifyError(ErrorType::BufferOverflow);
-                    state = ReceiveState::WaitingForHeader;
-                }
-            } else {
-                receivedLength++;
-            }
-            break;
-
-        case ReceiveState::ReceivingData:
-            if (byte == PacketEscape) {
-                state = ReceiveState::ReceivingEscape;
-            } else if (byte == PacketHeader) {
-                // 未エスケープのPacketHeaderを受信した場合
-                // 今読んでいたパケットは不完全で捨てる(エラーとして扱うなら notifyError も呼ぶ)
-                notifyError(ErrorType::UnexpectedHeader);
-
-                // 新しいパケットの先頭(ヘッダ)が来たとみなして、最初から受信やり直し
-                state = ReceiveState::ReceivingChecksum;
-                receivedChecksum = 0;
-                receivedLength   = 0;
-            } else {
-                receivedData[receivedLength++] = byte;
-                if (receivedLength == packetLength) {
-                    packetReceived();
-                    state = ReceiveState::WaitingForHeader;
-                } else if (receivedLength > packetLength) {
-                    notifyError(ErrorType::BufferOverflow);
-                    state = ReceiveState::WaitingForHeader;
-                }
-            }
-            break;
+#if __cplusplus < 201703L
+constexpr uint8_t ofxBinaryCommunicatorBase::HeaderByte;
+constexpr uint8_t ofxBinaryCommunicatorBase::EscapeByte;
+constexpr int ofxBinaryCommunicatorBase::ErrorTypeCount;
+#endif
 
-        case ReceiveState::ReceivingEscape:
-            if (byte == PacketHeader || byte == PacketEscape) {
-                receivedData[receivedLength++] = byte;
-                if (receivedLength == packetLength) {
-                    packetReceived();
-                    state = ReceiveState::WaitingForHeader;
-                } else if (receivedLength > packetLength) {
-                    notifyError(ErrorType::BufferOverflow);
-                    state = ReceiveState::WaitingForHeader;
-                } else {
-                    state = ReceiveState::ReceivingData;
-                }
-            } else {
-                // 不正なエスケープシーケンス
-                notifyError(ErrorType::UnknownError);
-                state = ReceiveState::WaitingForHeader;
-            }
-            break;
+size_t ofxBinaryCommunicatorBase::findSpecialByte(const uint8_t* data, size_t length) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i header32 = _mm256_set1_epi8((char)PacketHeader);
+    const __m256i escape32 = _mm256_set1_epi8((char)PacketEscape);
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, header32), _mm256_cmpeq_epi8(v, escape32));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit);
+        if (mask != 0) return i + countTrailingZeros(mask);
     }
-}
-
-// Handle a fully received packet
-bool ofxBinaryCommunicator::packetReceived() {
-    uint16_t calculatedChecksum = calculateChecksum(receivedData, packetLength);
-    if (calculatedChecksum == receivedChecksum) {
-        notifyReceived(ofxBinaryPacket(topicId, receivedLength, receivedData));
-        return true;
-    } else {
-        notifyError(ErrorType::ChecksumMismatch);
-        return false;
-    }}
-
-// Send a single byte
-void ofxBinaryCommunicator::sendByte(uint8_t byte) {
-    #ifdef OF_VERSION_MAJOR
-    if (serial != nullptr && serial->isInitialized()) {
-        serial->writeByte(byte);
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i header16 = _mm_set1_epi8((char)PacketHeader);
+    const __m128i escape16 = _mm_set1_epi8((char)PacketEscape);
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, header16), _mm_cmpeq_epi8(v, escape16));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask != 0) return i + countTrailingZeros(mask);
     }
-    #else
-    serial->write(byte);
-    #endif
-}
-
-uint16_t ofxBinaryCommunicator::calculateChecksum(const uint8_t* data, uint16_t length) {
-    // 16bit Fletcher's Checksum
-    uint8_t sum1 = 0xff;
-    uint8_t sum2 = 0xff;
-    
-    while (length--) {
-        sum1 += *data++;
-        sum2 += sum1;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t header16 = vdupq_n_u8(PacketHeader);
+    const uint8x16_t escape16 = vdupq_n_u8(PacketEscape);
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = vld1q_u8(data + i);
+        uint8x16_t hit = vorrq_u8(vceqq_u8(v, header16), vceqq_u8(v, escape16));
+        if (vmaxvq_u8(hit) != 0) break;
     }
-    
-    return (sum2 << 8) | sum1;
-}
-
-// Notify methods for platform-specific callback/event handling
-void ofxBinaryCommunicator::notifyReceived(const ofxBinaryPacket& packet) {
-#ifdef OF_VERSION_MAJOR
-    ofNotifyEvent(onReceived, packet);
-#else
-    if (onReceived) {
-        onReceived(packet);
+#endif
+#if !defined(__AVR__)
+    // Check 8 bytes at once (has-zero-byte trick), then locate the exact byte below
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+    const uint64_t header = ones * PacketHeader;
+    const uint64_t escape = ones * PacketEscape;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        uint64_t h = word ^ header;
+        uint64_t e = word ^ escape;
+        if ((((h - ones) & ~h) | ((e - ones) & ~e)) & highs) break;
     }
 #endif
+    for (; i < length; ++i) {
+        if (data[i] == PacketHeader || data[i] == PacketEscape) return i;
+    }
+    return length;
 }
 
-void ofxBinaryCommunicator::notifyError(ErrorType errorType) {
-#ifdef OF_VERSION_MAJOR
-    ofNotifyEvent(onError, errorType);
-#else
-    if (onError) {
-        onError(errorType);
+size_t ofxBinaryCommunicatorBase::escapePayload(const uint8_t* data, size_t length, uint8_t* out) {
+    uint8_t* begin = out;
+    while (length > 0) {
+        // Copy the clean run in one go
+        size_t run = findSpecialByte(data, length);
+        memcpy(out, data, run);
+        out += run;
+        data += run;
+        length -= run;
+        
+        if (length > 0) {
+            *out++ = PacketEscape;
+            *out++ = *data++;
+            length--;
+        }
     }
-#endif
+    return out - begin;
 }
@@ -13,11 +13,60 @@
 #define PacketEscape 0x98
 #endif
 
+// Transmit scratch buffer. Frames are escaped into it and written with a single call.
+// If a frame does not fit, it is written in several pieces.
+#ifndef SEND_BUFFER_SIZE
+    #if defined(ARDUINO)
+        #define SEND_BUFFER_SIZE 64
+    #else
+        #define SEND_BUFFER_SIZE (MAX_PACKET_SIZE * 2 + 8)
+    #endif
+#endif
+
+// Chunk size for draining the serial buffer in update() (openFrameworks)
+#ifndef READ_BUFFER_SIZE
+#define READ_BUFFER_SIZE 4096
+#endif
+
+// Number of topics that can be subscribed at once (Arduino). openFrameworks has a slot for every topicId.
+#ifndef MAX_SUBSCRIPTIONS
+#define MAX_SUBSCRIPTIONS 8
+#endif
+
+// Number of topics that can be delta encoded at once (Arduino). openFrameworks has a slot for every topicId.
+#ifndef MAX_DELTA_TOPICS
+#define MAX_DELTA_TOPICS 4
+#endif
+
+// Number of reliable topics that can be sent, and received, at once (Arduino). openFrameworks has a slot for every topicId.
+#ifndef MAX_RELIABLE_TOPICS
+#define MAX_RELIABLE_TOPICS 2
+#endif
+
+// Link counters (getLinkStats()). 0 compiles them out. On by default except on Arduino.
+#ifndef LINK_STATS
+    #if defined(ARDUINO)
+        #define LINK_STATS 0
+    #else
+        #define LINK_STATS 1
+    #endif
+#endif
+
 #include <stdint.h>
 #include <string.h>
+#include "ofxBinaryCommunicatorChecksum.h"
 
 #if !defined(ARDUINO)
     #include "ofMain.h"
+    #include <condition_variable>
+    #include <functional>
+    #include <mutex>
+    #include <random>
+    #include <thread>
+    #include "ofxBinaryCommunicatorClockSync.h"
+    #include "ofxBinaryCommunicatorHistogram.h"
+    #include "ofxBinaryCommunicatorQueue.h"
+    #include "ofxBinaryCommunicatorTransport.h"
 #endif
 
 #ifndef OF_VERSION_MAJOR
@@ -29,9 +78,17 @@
 
 // Packet data struct
 struct ofxBinaryPacket {
+    // Receive buffers are aligned to this, so view() works for structs up to this alignment
+    static const size_t dataAlignment = 8;
+    
     uint8_t topicId;
     uint16_t length;
     const uint8_t* data;
+#ifdef OF_VERSION_MAJOR
+    // ofGetElapsedTimeMicros() when the frame's header was read from the transport (openFrameworks only).
+    // Taken once per read, before decoding, so queues and handlers don't delay it. 0 for packets built locally.
+    uint64_t arrivalMicros = 0;
+#endif
     
     ofxBinaryPacket(uint8_t _topicId, uint16_t _length, const uint8_t* _data)
     : topicId(_topicId), length(_length), data(_data) {}
@@ -49,9 +106,22 @@ struct ofxBinaryPacket {
         memcpy(&out, data, sizeof(T));
         return true;
     }
+    
+    // Read the payload in place without copying. Returns nullptr if topicId, length or alignment don't match.
+    // In onReceived or a subscribe() handler, the pointer is valid until the handler returns.
+    template<typename T>
+    const T* view(decltype(T::topicId)* = 0) const {
+        if (T::topicId != topicId) return nullptr;
+        if (length != sizeof(T)) return nullptr;
+        if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0) return nullptr;
+        return reinterpret_cast<const T*>(data);
+    }
 };
 
-class ofxBinaryCommunicator {
+struct OscLikeMessage;
+
+// Types and framing shared by every ofxBasicBinaryCommunicator
+class ofxBinaryCommunicatorBase {
 public:
     // Error types that can occur during communication
     enum class ErrorType {
@@ -59,8 +129,12 @@ public:
         IncompletePacket,
         BufferOverflow,
         UnexpectedHeader,
-        UnknownError
+        UnknownError,
+        TransferTimeout, // a sendLarge() payload stopped arriving
+        DeliveryFailed,  // a reliable packet was not acknowledged after every retry
+        WriteFailed      // a frame was not written completely (the transport closed, or stayed full)
     };
+    static constexpr int ErrorTypeCount = (int)ErrorType::WriteFailed + 1;
     
 #ifdef OF_VERSION_MAJOR
     static string ErrorToString(ErrorType error) {
@@ -73,6 +147,12 @@ public:
                 return "BufferOverflow";
             case ErrorType::UnexpectedHeader:
                 return "UnexpectedHeader";
+            case ErrorType::TransferTimeout:
+                return "TransferTimeout";
+            case ErrorType::DeliveryFailed:
+                return "DeliveryFailed";
+            case ErrorType::WriteFailed:
+                return "WriteFailed";
             case ErrorType::UnknownError:
                 return "UnknownError";
             default:
@@ -81,40 +161,362 @@ public:
     }
 #endif
     
-    ofxBinaryCommunicator();
-    ~ofxBinaryCommunicator();
+    // Bytes with a meaning on the wire. Payload bytes equal to either are escaped.
+    static constexpr uint8_t HeaderByte = PacketHeader;
+    static constexpr uint8_t EscapeByte = PacketEscape;
+    
+    // Counters of a reliable topic (enableReliable())
+    struct ReliableStats {
+        uint32_t sent;          // packets accepted by send
+        uint32_t acked;
+        uint32_t retransmitted; // frames sent again
+        uint32_t failed;        // given up after every retry (DeliveryFailed)
+        uint32_t rejected;      // the window was full or the payload too large
+        uint32_t duplicates;    // receiving side: arrived again and dropped
+        uint16_t inFlight;      // sent but not acknowledged yet
+        uint16_t rttMillis;     // smoothed round trip time, 0 before the first sample
+        uint16_t rtoMillis;     // current retransmission timeout
+    };
+    
+#if LINK_STATS
+    #ifdef OF_VERSION_MAJOR
+    typedef uint64_t LinkCounter;
+    #else
+    typedef uint32_t LinkCounter;
+    #endif
+    
+    // Totals of getLinkStats() since the communicator was created. Diff two snapshots for rates.
+    // Frames are counted as they go on the wire, so delta, reliable and fragment frames count under their own topics.
+    struct LinkStats {
+        LinkCounter rxBytes;        // read from the transport
+        LinkCounter rxFrames;       // frames with a matching checksum
+        LinkCounter rxPayloadBytes;
+        LinkCounter rxEscapes;      // escape bytes in the received payloads
+        LinkCounter txBytes;        // written to the transport
+        LinkCounter txFrames;
+        LinkCounter txPayloadBytes;
+        LinkCounter txEscapes;      // escape bytes added to the sent payloads
+        LinkCounter resyncs;        // times bytes were skipped to find the next header
+        LinkCounter skippedBytes;   // bytes skipped before a header
+        LinkCounter errors[ErrorTypeCount]; // onError by ErrorType
+        int maxBacklog;             // most bytes available() reported before a read
+        
+        // Escape bytes per payload byte: 0 for clean data, 1 if every byte needed escaping
+        float getRxEscapeOverhead() const { return rxPayloadBytes > 0 ? (float)rxEscapes / rxPayloadBytes : 0; }
+        float getTxEscapeOverhead() const { return txPayloadBytes > 0 ? (float)txEscapes / txPayloadBytes : 0; }
+        LinkCounter getErrorCount(ErrorType error) const { return errors[(int)error]; }
+    };
+    
+    #ifdef OF_VERSION_MAJOR
+    // Per topic counters of getTopicStats() (openFrameworks only)
+    struct TopicStats {
+        LinkCounter rxPackets;
+        LinkCounter rxBytes; // payload bytes
+        LinkCounter txPackets;
+        LinkCounter txBytes;
+    };
+    #endif
+#endif
+    
+#ifndef OF_VERSION_MAJOR
+    // callback for Arduino
+    typedef void (*ReceivedCallback)(const ofxBinaryPacket& packet);
+    typedef void (*ErrorCallback)(ErrorType errorType);
+    
+    typedef void (*SubscriberFunction)();
+    typedef void (*SubscriberInvoker)(const ofxBinaryPacket& packet, SubscriberFunction handler);
+#endif
+    
+#ifdef OF_VERSION_MAJOR
+    // Threaded receive (openFrameworks only)
+    // A reader thread decodes incoming frames into a preallocated queue.
+    // update() then only drains the queue and fires onReceived/onError on the calling thread.
+    enum class QueueFullPolicy {
+        DropNewest, // discard what does not fit
+        Block       // stop reading until update() makes room (the OS buffer backs up instead)
+    };
+    
+    struct ReceiveQueueStats {
+        uint64_t queued;      // packets and errors pushed by the reader thread
+        uint64_t dropped;     // discarded because the queue was full
+        size_t depth;         // entries waiting for update()
+        size_t highWaterMark; // max depth seen
+    };
+    
+    // Asynchronous send (openFrameworks only)
+    // Frames are encoded on the calling thread into a lock-free queue and written by a writer thread.
+    // While it runs, every send (sendPacket, send, sendPackets) goes through the queue,
+    // so they are safe to call from several threads at once.
+    enum class BackpressurePolicy {
+        Block,       // wait until there is room
+        DropOldest,  // discard the oldest queued frame
+        DropNewest,  // discard the frame being sent
+        ReturnError  // don't queue, return SendResult::QueueFull
+    };
+    
+    // Transmit priority of a topic. The writer thread keeps a queue per class.
+    enum class SendPriority {
+        Control, // written before anything else
+        Normal,  // default
+        Bulk     // shares what Control leaves with Normal, by weight
+    };
+    
+    enum class SendResult {
+        Ok,
+        Dropped,   // discarded by DropNewest
+        QueueFull, // rejected by ReturnError
+        TooLarge   // payload is larger than the communicator's MaxPacket
+    };
+    
+    struct SendQueueStats {
+        uint64_t queued;      // frames pushed by senders
+        uint64_t dropped;     // discarded by DropOldest/DropNewest
+        size_t depth;         // frames waiting for the writer
+        size_t highWaterMark; // max depth seen
+    };
+    
+    // Coalescing send (openFrameworks only): per topic counters of setCoalescing()
+    struct CoalesceStats {
+        uint64_t submitted;  // packets passed to send
+        uint64_t sent;       // packets written
+        uint64_t superseded; // replaced by a newer one before they went out
+        bool pending;        // a packet is waiting
+    };
+    
+    // Round trips of sendPing() (openFrameworks only), in microseconds
+    struct PingStats {
+        uint64_t sent;
+        uint64_t received; // pongs; the rest were lost or are still on their way
+        uint32_t minMicros;
+        uint32_t p50Micros;
+        uint32_t p99Micros;
+        uint32_t p999Micros;
+        uint32_t maxMicros;
+        double meanMicros;
+    };
+    
+    // The other end's clock as estimated from ping exchanges (openFrameworks only)
+    struct ClockSyncStats {
+        bool synchronized;           // at least one Pong arrived
+        double offsetMicros;         // other end's clock minus this one's, now
+        double driftPpm;             // how much faster the other end's clock runs, in parts per million
+        uint32_t minRoundTripMicros; // of the exchanges the estimate uses
+        size_t samples;
+    };
+    
+    // Streaming receive (openFrameworks only)
+    // Frames of a streamed topic are not buffered. onChunk gets the unescaped payload piece by piece
+    // as it arrives, and the checksum is computed along the way, so frames may be longer than
+    // MaxPacket (up to 65535 bytes, sent with sendPacket() without the writer thread).
+    // onCommit or onAbort fires when the frame ends; only commit means the data was intact.
+    // Handlers run on the decoding thread (update() or the receive thread). Set them before startReceiveThread().
+    struct StreamHandler {
+        std::function<void(uint8_t topicId, uint16_t length)> onBegin;
+        std::function<void(const uint8_t* data, size_t length)> onChunk;
+        std::function<void()> onCommit;
+        std::function<void(ErrorType error)> onAbort;
+    };
+#endif
+    
+protected:
+#if LINK_STATS
+    // Counter with one writing thread at a time, read from any thread. The add is a plain load and store,
+    // not a locked read-modify-write, so counting costs next to nothing on the hot paths.
+    struct StatCounter {
+    #ifdef OF_VERSION_MAJOR
+        std::atomic<LinkCounter> value;
+        StatCounter() : value(0) {}
+        void add(LinkCounter n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        LinkCounter get() const { return value.load(std::memory_order_relaxed); }
+    #else
+        LinkCounter value;
+        StatCounter() : value(0) {}
+        void add(LinkCounter n) { value += n; }
+        LinkCounter get() const { return value; }
+    #endif
+    };
+#endif
+    
+    enum class ReceiveState {
+        WaitingForHeader,
+        ReceivingChecksum,
+        ReceivingTopicId,
+        ReceivingLength,
+        ReceivingData,
+        ReceivingEscape
+    };
+    
+    // Find the first HeaderByte or EscapeByte. Returns length if there is none.
+    static size_t findSpecialByte(const uint8_t* data, size_t length);
+    // Escape a payload into out (at most length * 2 bytes). Returns the number of bytes written.
+    static size_t escapePayload(const uint8_t* data, size_t length, uint8_t* out);
+};
+
+#include "ofxBinaryCommunicatorExecutor.h"
+
+// The communicator, specialized at compile time.
+//   MaxPacket: largest payload of one frame. The receive buffers are exactly this size.
+//   Checksum:  ofxBinaryChecksum negotiates the type at runtime (requestChecksumType()).
+//              ofxBinaryFletcher16, ofxBinaryCRC16 or ofxBinaryCRC32C fix it, so the checksum is inlined.
+//   Transport: openFrameworks: the ofxBinaryTransport class passed to setup(). A final backend
+//              (ofxBinaryLoopbackTransport, ofxBinarySocketTransport, ...) is called without virtual dispatch.
+//              Arduino: the Stream class passed to setup(), e.g. HardwareSerial.
+// ofxBinaryCommunicator is this with MAX_PACKET_SIZE and the defaults.
+#ifdef OF_VERSION_MAJOR
+template<size_t MaxPacket = MAX_PACKET_SIZE, typename Checksum = ofxBinaryChecksum, typename Transport = ofxBinaryTransport>
+#else
+template<size_t MaxPacket = MAX_PACKET_SIZE, typename Checksum = ofxBinaryChecksum, typename Transport = Stream>
+#endif
+class ofxBasicBinaryCommunicator : public ofxBinaryCommunicatorBase {
+    static_assert(MaxPacket > 0 && MaxPacket <= 0xFFFF, "MaxPacket must fit the 16 bit length field");
+    
+public:
+    typedef ofxBinaryChecksumTraits<Checksum> ChecksumTraits;
+    typedef Transport TransportType;
+    
+    ofxBasicBinaryCommunicator();
+    ~ofxBasicBinaryCommunicator();
     
     // Setup method to initialize the communicator
 #ifdef OF_VERSION_MAJOR
+    // Opens an ofSerial. Only available when Transport is ofxBinaryTransport or ofxBinarySerialTransport.
     void setup(const string& port, int baudRate);
+    // Run over any byte stream (loopback, pty, socket, ...)
+    void setup(std::shared_ptr<Transport> transport);
+    std::shared_ptr<Transport> getTransport() const { return transport; }
 #else
     void setup(HardwareSerial& serialDevice, int baudRate);
-    void setup(Stream& serialDevice);
+    void setup(Transport& serialDevice);
 #endif
     
     void update();
     
+#ifdef OF_VERSION_MAJOR
+    // Decode what the transport has received, without asking available() first.
+    // For loops that already know the port is readable (ofxBinaryCommunicatorHub). Returns the number of bytes read.
+    // It doesn't run the timers: call updateTimers() on every pass too, readable or not.
+    size_t updateReadable();
+    // Whether updateTimers() has anything to wait for, so a poll loop shouldn't sleep for long
+    bool hasTimers() const;
+#endif
+    
+    // Work that is due by the clock rather than by received bytes: reliable retransmissions, and on
+    // openFrameworks write errors, timed out sendLarge() transfers, due coalesced packets and pings.
+    // update() calls it.
+    void updateTimers();
+    
 #ifdef OF_VERSION_MAJOR
     // callback for openFrameworks
     ofEvent<const ofxBinaryPacket> onReceived;
     ofEvent<ErrorType> onError;
 #else
-    // callback for Arduino
-    typedef void (*ReceivedCallback)(const ofxBinaryPacket& packet);
-    typedef void (*ErrorCallback)(ErrorType errorType);
-    
     // Arduino specific methods to set callbacks
     void setReceivedCallback(ReceivedCallback callback) { onReceived = callback; }
     void setErrorCallback(ErrorCallback callback) { onError = callback; }
 #endif
     
+    // Call handler with the unpacked struct whenever a T arrives.
+    // The handler is looked up by topicId, so packets of other topics never reach it.
+    // One handler per topic; subscribing again replaces it. onReceived still fires for every packet.
+#ifdef OF_VERSION_MAJOR
+    template<typename T>
+    bool subscribe(std::function<void(const T&)> handler, decltype(T::topicId)* = 0) {
+        if (!handler) {
+            unsubscribe(T::topicId);
+            return true;
+        }
+        subscribers[T::topicId] = [handler](const ofxBinaryPacket& packet) {
+            const T* data = packet.view<T>();
+            if (data != nullptr) {
+                handler(*data);
+                return;
+            }
+            T copy; // payload not aligned for T
+            if (packet.unpack(copy)) handler(copy);
+        };
+        return true;
+    }
+    void unsubscribe(uint8_t topicId) { subscribers[topicId] = nullptr; }
+#else
+    // Returns false if MAX_SUBSCRIPTIONS topics are already subscribed
+    template<typename T>
+    bool subscribe(void (*handler)(const T&), decltype(T::topicId)* = 0) {
+        return addSubscription(T::topicId, &invokeSubscriber<T>, reinterpret_cast<SubscriberFunction>(handler));
+    }
+    void unsubscribe(uint8_t topicId);
+#endif
+    
     bool isInitialized() const { return initialized; }
     void close() {
 #ifdef OF_VERSION_MAJOR
-        serial->close();
+        stopSendThread();
+        stopReceiveThread();
+        if (transport) transport->close();
 #endif
     }
     
+#ifdef OF_VERSION_MAJOR
+    void startReceiveThread(size_t queueDepth = 256, QueueFullPolicy policy = QueueFullPolicy::DropNewest);
+    void stopReceiveThread();
+    bool isReceiveThreadRunning() const { return receiveThread.joinable(); }
+    ReceiveQueueStats getReceiveQueueStats() const;
+    
+    // Run subscribe() handlers and onReceived on the executor's worker pool instead of the decoding
+    // thread. nullptr (the default) runs them inline. Checksum negotiation, sendLarge() reassembly and
+    // onError stay on the decoding thread. Set it while nothing is decoding (before startReceiveThread()).
+    void setExecutor(std::shared_ptr<ofxBinaryCommunicatorExecutor> executor);
+    std::shared_ptr<ofxBinaryCommunicatorExecutor> getExecutor() const { return executor; }
+    
+    void startSendThread(size_t queueDepth = 256, BackpressurePolicy policy = BackpressurePolicy::Block);
+    void stopSendThread(); // writes out what is still queued
+    bool isSendThreadRunning() const { return sendThread.joinable(); }
+    
+    // Without the writer thread these write synchronously
+    SendResult sendPacketAsync(const ofxBinaryPacket& packet);
+    template<typename T>
+    SendResult sendAsync(const T& data, decltype(T::topicId)* = 0) {
+        return sendPacketAsync(ofxBinaryPacket(data));
+    }
+    
+    // Priorities are applied by the writer thread; without it every send is written before it returns.
+    // Queued Control frames always go next. Normal and Bulk share the rest in bytes, normalWeight to
+    // bulkWeight (default 4:1), so neither can starve the other. A frame is never cut short, but
+    // sendLarge() fragments and delta frames are queued under the priority of their payload topic,
+    // so control frames get through between the fragments of a large transfer.
+    // Set them before startSendThread(): a class no topic uses gets no queue.
+    void setSendPriority(uint8_t topicId, SendPriority priority) { sendPriorities[topicId] = priority; }
+    template<typename T>
+    void setSendPriority(SendPriority priority, decltype(T::topicId)* = 0) {
+        setSendPriority(T::topicId, priority);
+    }
+    SendPriority getSendPriority(uint8_t topicId) const { return sendPriorities[topicId]; }
+    void setSendWeights(uint32_t normalWeight, uint32_t bulkWeight);
+    
+    // Wait until every queued frame has been written. Returns false on timeout.
+    bool flush(float timeoutSec = 1.0f);
+    SendQueueStats getSendQueueStats() const;
+    
+    // Latest value wins: after setCoalescing(), sends of the topic (send, sendAsync, sendPackets, ...)
+    // are written at once only while the link keeps up, i.e. the transport holds at most the watermark
+    // unsent and the writer thread's queue is empty. Otherwise the packet waits in the topic's one
+    // pending slot, and a newer send replaces it. update() writes pending packets once there is room.
+    // maxRateHz > 0 also limits the topic to that many packets per second.
+    // For positions, knobs and other state where only the newest value matters. Don't use it for events.
+    // Returns false for a reserved topic. Set it before sending from other threads.
+    bool setCoalescing(uint8_t topicId, float maxRateHz = 0);
+    template<typename T>
+    bool setCoalescing(float maxRateHz = 0, decltype(T::topicId)* = 0) {
+        return setCoalescing(T::topicId, maxRateHz);
+    }
+    void clearCoalescing(uint8_t topicId); // writes the pending packet first
+    // Unsent bytes the transport may hold while coalesced packets are written (default 64).
+    // Transports that can't tell (pendingWrite() < 0) are always considered to have room.
+    void setCoalescingWatermark(size_t bytes) { coalescingWatermark = bytes; }
+    // Write the pending packets that are due. updateTimers() calls it. Returns the number written.
+    size_t flushCoalesced();
+    CoalesceStats getCoalesceStats(uint8_t topicId) const;
+#endif
+    
     void sendPacket(const ofxBinaryPacket& packet);
     template<typename T>
     void send(const T& data, decltype(T::topicId)* = 0) {
@@ -122,48 +524,502 @@ public:
         sendPacket(packet);
     }
     
+    // OscLikeMessage in its compact form (OscLikeMessage::encode()): only the address, the type codes and
+    // the arguments in use, instead of the whole 192 byte struct. Receivers read both forms.
+    void sendCompact(const OscLikeMessage& message);
+    
+    // Send several packets coalesced into as few writes as possible
+    void sendPackets(const ofxBinaryPacket* packets, size_t count);
+#ifdef OF_VERSION_MAJOR
+    void sendPackets(const vector<ofxBinaryPacket>& packets) {
+        sendPackets(packets.data(), packets.size());
+    }
+#endif
+    
+#ifdef OF_VERSION_MAJOR
+    void setStreamHandler(uint8_t topicId, const StreamHandler& handler);
+    void clearStreamHandler(uint8_t topicId) { streamHandlers[topicId].reset(); }
+#endif
+    
+    // Send a payload larger than MaxPacket (up to 65535 bytes) as a sequence of fragments.
+    // The receiver reassembles it and delivers it like any other packet (onReceived, subscribe()).
+    // Payloads that fit in one frame go through sendPacket() as usual.
+    // Reassembly is openFrameworks only. Returns false if the payload is too large, or if MaxPacket
+    // leaves no room for a fragment's data next to its FragmentHeader (MaxPacket <= 7).
+    bool sendLarge(uint8_t topicId, const uint8_t* data, size_t length);
+    template<typename T>
+    bool sendLarge(const T& data, decltype(T::topicId)* = 0) {
+        return sendLarge(T::topicId, reinterpret_cast<const uint8_t*>(&data), sizeof(T));
+    }
+    
+    // Delta encoding: after enableDelta<T>(), send() transmits only the bytes of T that changed since the
+    // previous send, plus a bitmap of them. Every keyframeInterval-th frame (0: never) carries the whole
+    // struct, and so does the next one after the receiver asks for it (it does when a frame was lost).
+    // The receiver rebuilds T before onReceived and subscribe() see it. Decoding is openFrameworks only.
+    // Returns false for a reserved topic, a payload that doesn't fit MaxPacket with the delta header,
+    // or when MAX_DELTA_TOPICS topics are already enabled (Arduino).
+    bool enableDelta(uint8_t topicId, uint16_t maxLength, uint16_t keyframeInterval = 32);
+    template<typename T>
+    bool enableDelta(uint16_t keyframeInterval = 32, decltype(T::topicId)* = 0) {
+        return enableDelta(T::topicId, sizeof(T), keyframeInterval);
+    }
+    void disableDelta(uint8_t topicId);
+    
+    // Reliable delivery: after enableReliable<T>(), every send() of T carries a sequence number and stays
+    // buffered until the receiver acknowledges it. Up to window packets (1 to 32, rounded up to a power
+    // of two) are in flight at once. Every ack carries the receiver's cumulative and selective state, so
+    // only missing packets are sent again: after a timeout derived from the measured round trip time, or
+    // as soon as a later packet is acknowledged. After ReliableMaxRetries tries onError gets DeliveryFailed.
+    // The receiver needs no setup. It drops duplicates, but a packet that had to be sent again may arrive
+    // after later ones. When the window is full, send() drops the packet and counts it as rejected
+    // (sendAsync() returns QueueFull); check canSendReliable() first. Delta encoding is not applied.
+    // The sender buffers window * maxLength bytes. Returns false for a reserved topic, a payload that
+    // doesn't fit MaxPacket with the header, or when MAX_RELIABLE_TOPICS topics are already enabled (Arduino).
+    bool enableReliable(uint8_t topicId, uint16_t maxLength, uint8_t window = 8);
+    template<typename T>
+    bool enableReliable(uint8_t window = 8, decltype(T::topicId)* = 0) {
+        return enableReliable(T::topicId, sizeof(T), window);
+    }
+    void disableReliable(uint8_t topicId);
+    bool canSendReliable(uint8_t topicId);
+    ReliableStats getReliableStats(uint8_t topicId);
+    
+    static constexpr uint8_t ReliableMaxRetries = 10;
+    static constexpr uint16_t ReliableInitialRtoMillis = 200;
+    static constexpr uint16_t ReliableMinRtoMillis = 10;
+    static constexpr uint16_t ReliableMaxRtoMillis = 2000;
+    
+#if LINK_STATS
+    // Snapshot of the link counters, safe to take from any thread. Counting is off on Arduino
+    // unless LINK_STATS is defined to 1 before the include; with 0 these and the counters compile out.
+    LinkStats getLinkStats() const;
+    #ifdef OF_VERSION_MAJOR
+    // Packets and payload bytes of one topic, by the topicId on the wire
+    TopicStats getTopicStats(uint8_t topicId) const;
+    #endif
+#endif
+    
+#ifdef OF_VERSION_MAJOR
+    // Round trip latency: sendPing() sends a Ping, and the other end answers with a Pong inside its
+    // update() (Arduino and openFrameworks alike, no setup). The round trip of every Pong goes into a
+    // histogram, measured on the decoding thread so that update() timing doesn't skew it. It includes the
+    // time the Ping waits in this end's send queue; setSendPriority<Ping>(Control) keeps that short.
+    void sendPing();
+    // Send a Ping every 1 / rateHz seconds from updateTimers() (update(), or the hub's poll()). 0 (the default) stops.
+    void setPingRate(float rateHz);
+    PingStats getPingStats() const;
+    void resetPingStats();
+    
+    // Clock sync: every Pong also carries the other end's clock. Like NTP, the exchanges with the shortest
+    // round trips (the least room for one leg to be slower) give its offset and drift, so timestamps
+    // taken with millis() or micros() on the other end map onto this end's clock. Keep pinging
+    // (setPingRate(1) is plenty) to follow the drift; a restart of the other end is detected and starts over.
+    // Together with ofxBinaryPacket::arrivalMicros this gives one-way latency:
+    //     packet.arrivalMicros - communicator.deviceToHostMicros(data.timestamp)
+    // deviceToHostTime(): a millis() timestamp of the other end as ofGetElapsedTimeMillis()
+    uint64_t deviceToHostTime(uint32_t deviceMillis) const;
+    // A micros() timestamp as ofGetElapsedTimeMicros(). It must be within 35 minutes of the latest Pong.
+    uint64_t deviceToHostMicros(uint32_t deviceMicros) const;
+    ClockSyncStats getClockSyncStats() const;
+    
+    // Ask the sender of a delta encoded topic for a keyframe
+    void requestDeltaKeyframe(uint8_t topicId);
+    
+    // Drop an incomplete large payload when no fragment arrived for timeoutSec (TransferTimeout)
+    void setLargeTransferTimeout(float timeoutSec) { largeTransferTimeoutMillis = timeoutSec * 1000; }
+    // Large payloads reassembled at once (default 8). Further transfers are dropped with BufferOverflow.
+    void setMaxLargeTransfers(size_t count) { maxLargeTransfers = count; }
+#endif
+    
+    static constexpr size_t MaxPacketSize = MaxPacket;
+    
+    // Frame layout: header(1) checksum(2 or 4) topicId(1) length(2) escaped payload
+    static constexpr size_t MaxFrameHeaderSize = 4 + ChecksumTraits::maxSize;
+    
+#ifdef SEND_BUFFER_SIZE
+    static constexpr size_t SendBufferSize = SEND_BUFFER_SIZE;
+#else
+    static constexpr size_t SendBufferSize = MaxFrameHeaderSize + MaxPacket * 2;
+#endif
+    
+    static constexpr size_t getFrameHeaderSize(ofxBinaryChecksumType checksumType) {
+        return 4 + ChecksumTraits::getSize(checksumType);
+    }
+    
+    // Worst case encoded size (every payload byte escaped)
+    static constexpr size_t getMaxFrameSize(uint16_t payloadLength) {
+        return MaxFrameHeaderSize + (size_t)payloadLength * 2;
+    }
+    
+    // Encode a whole frame into out, which must hold getMaxFrameSize(packet.length) bytes.
+    // Returns the number of bytes written.
+    static size_t encodeFrame(const ofxBinaryPacket& packet, uint8_t* out, ofxBinaryChecksumType checksumType = ChecksumTraits::defaultType());
+    
+    // Checksum that goes into the frame header
+    static uint32_t calculateChecksum(const uint8_t* data, uint16_t length, ofxBinaryChecksumType checksumType = ChecksumTraits::defaultType());
+    
+    // Checksum used on this link. Both ends must use the same one.
+    // setChecksumType() only changes this end; requestChecksumType() asks the other end to
+    // switch too (ChecksumRequest), and this end follows when it accepts (ChecksumResponse).
+    // Switch while the link is quiet: frames already on the wire fail with ChecksumMismatch.
+    // A communicator with a fixed Checksum ignores other types and refuses requests for them.
+    void setChecksumType(ofxBinaryChecksumType type) {
+        if (ChecksumTraits::isSupported((uint8_t)type)) checksumType = type;
+    }
+    ofxBinaryChecksumType getChecksumType() const { return checksumType; }
+    void requestChecksumType(ofxBinaryChecksumType type);
+    
+    // Whether a ChecksumRequest from the other end is accepted (default true)
+    void setAcceptChecksumRequests(bool accept) { acceptChecksumRequests = accept; }
+    
     // serialを直接触りたい時が結構あるので、あえてpublicのまま
 #ifdef OF_VERSION_MAJOR
-    ofSerial* serial = nullptr;
+    ofSerial* serial = nullptr; // nullptr when set up with a custom transport
 #else
-    Stream* serial;
+    Transport* serial;
+#endif
     
 private:
     
+#ifndef OF_VERSION_MAJOR
     // Arduino specific callback function pointers
     ReceivedCallback onReceived;
     ErrorCallback onError;
+    
+    template<typename T>
+    static void invokeSubscriber(const ofxBinaryPacket& packet, SubscriberFunction handler) {
+        const T* data = packet.view<T>();
+        if (data != nullptr) {
+            reinterpret_cast<void (*)(const T&)>(handler)(*data);
+            return;
+        }
+        T copy; // payload not aligned for T
+        if (packet.unpack(copy)) reinterpret_cast<void (*)(const T&)>(handler)(copy);
+    }
+    bool addSubscription(uint8_t topicId, SubscriberInvoker invoker, SubscriberFunction handler);
+    
+    struct Subscription {
+        uint8_t topicId;
+        SubscriberInvoker invoker;
+        SubscriberFunction handler;
+    };
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    uint8_t subscriptionCount;
 #endif
     
     // Private methods to handle different aspects of communication
     void processIncomingByte(uint8_t incomingByte);
+    void processIncomingBytes(const uint8_t* data, size_t length);
+    void storeReceivedByte(uint8_t byte);
+    void storeReceivedRun(const uint8_t* data, size_t length);
     bool packetReceived();
-    void sendByte(uint8_t byte);
-    uint16_t calculateChecksum(const uint8_t* data, uint16_t length);
+    void bufferFrame(const ofxBinaryPacket& packet);
+    void flushSendBuffer();
+    void writeTransport(const uint8_t* data, size_t length);
+    static size_t encodeFrameHeader(const ofxBinaryPacket& packet, uint8_t* out, ofxBinaryChecksumType checksumType);
+#if LINK_STATS
+    void countSentFrame(uint8_t topicId, uint16_t payloadLength, size_t escapes);
+#endif
+    
+    // Answer the built-in reserved topics. Returns true if the packet was consumed.
+    bool handleReservedPacket(const ofxBinaryPacket& packet);
+    // Reserved topics that handleReservedPacket() consumes. They are never handed to the executor.
+    static bool isInternalTopic(uint8_t topicId);
+    
+    struct DeltaSender;
+    DeltaSender* findDeltaSender(uint8_t topicId);
+    template<typename Send>
+    auto sendEncoded(const ofxBinaryPacket& packet, Send send) -> decltype(send(packet));
+    ofxBinaryPacket encodeDelta(DeltaSender& delta, const ofxBinaryPacket& packet, uint8_t* payload);
+    
+    struct ReliableSender;
+    struct ReliableReceiver;
+    ReliableSender* findReliableSender(uint8_t topicId);
+    ReliableReceiver* findReliableReceiver(uint8_t topicId, bool create);
+    static uint32_t getMillis();
+    ofxBinaryPacket encodeReliable(ReliableSender& reliable, uint16_t sequence, uint8_t* payload);
+    void resendReliable(ReliableSender& reliable, uint16_t sequence, uint32_t now);
+    void acknowledgeReliable(ReliableSender& reliable, uint16_t sequence, uint32_t now);
+    uint8_t retransmitReliable(ReliableSender& reliable, uint32_t now);
+    void receiveReliable(const ofxBinaryPacket& packet);
+    void receiveReliableAck(const ofxBinaryPacket& packet);
+    size_t updateReliable();
+    void deliverPayload(const ofxBinaryPacket& packet);
+    static void sendRejected(void*) {}
+#ifdef OF_VERSION_MAJOR
+    static SendResult sendRejected(SendResult*) { return SendResult::QueueFull; }
+#endif
     
     // Methods to notify callbacks/events (implementation differs between platforms)
     void notifyReceived(const ofxBinaryPacket& packet);
     void notifyError(ErrorType errorType);
+    void notifySubscriber(const ofxBinaryPacket& packet);
+#ifdef OF_VERSION_MAJOR
+    size_t readTransport();
+    void beginStream();
+    void stageStreamByte(uint8_t byte);
+    void flushStreamChunk();
+    void deliverStreamChunk(const uint8_t* data, size_t length);
+    bool finishStream();
+    void abortStream(ErrorType error);
+    void receiveThreadFunction();
+    void drainReceiveQueue();
+    void dispatchReceived(const ofxBinaryPacket& packet);
+    void deliverReceived(const ofxBinaryPacket& packet);
+    void dispatchError(ErrorType errorType);
+    void reportWriteFailures();
+    struct ReceivedSlot;
+    ReceivedSlot* queueSlot();
+    void commitSlot();
+    SendResult queueFrame(const ofxBinaryPacket& packet, SendPriority priority = SendPriority::Normal);
+    size_t getSendQueueDepth() const;
+    bool writeNextFrame();
+    bool coalesce(const ofxBinaryPacket& packet);
+    bool hasSendRoom();
+    void receiveDelta(const ofxBinaryPacket& packet);
+    void receivePong(const ofxBinaryPacket& packet);
+    void sendThreadFunction();
+    void bufferEncodedFrame(const uint8_t* frame, size_t length);
+    struct LargeTransfer;
+    void receiveFragment(const ofxBinaryPacket& packet);
+    void releaseLargeTransfer(typename std::vector<LargeTransfer>::iterator transfer);
+    void expireLargeTransfers();
+#endif
     
     bool initialized;
     
-    enum class ReceiveState {
-        WaitingForHeader,
-        ReceivingChecksum,
-        ReceivingTopicId,
-        ReceivingLength,
-        ReceivingData,
-        ReceivingEscape
-    };
-    
     ReceiveState state;
-    uint16_t receivedChecksum;
+#ifdef OF_VERSION_MAJOR
+    std::atomic<ofxBinaryChecksumType> checksumType; // set from update() while the reader thread decodes
+#else
+    ofxBinaryChecksumType checksumType;
+#endif
+    ofxBinaryChecksumType receivingChecksumType; // fixed for the frame being received
+    ofxBinaryChecksumType requestedChecksumType;
+    bool checksumRequestPending;
+    bool acceptChecksumRequests;
+    uint32_t receivedChecksum;
     uint8_t topicId;
     uint16_t packetLength;
     uint16_t receivedLength;
-    uint8_t receivedData[MAX_PACKET_SIZE];
+    alignas(ofxBinaryPacket::dataAlignment) uint8_t receivedData[MaxPacket];
+#ifdef OF_VERSION_MAJOR
+    uint8_t readBuffer[READ_BUFFER_SIZE];
+#endif
+    
+    uint8_t sendBuffer[SendBufferSize];
+    size_t sendBufferLength;
+    // Payload of the frame being built by sendLarge(), sendEncoded() or resendReliable(),
+    // so each doesn't put MaxPacket bytes on the stack
+    uint8_t framePayload[MaxPacket];
+#ifdef OF_VERSION_MAJOR
+    std::mutex framePayloadMutex; // held while framePayload is filled and queued, after reliableMutex or deltaMutex
+#endif
+    
+#if LINK_STATS
+    // Receive counters are written by the decoding thread, send counters by the thread that writes
+    // (the writer thread while it runs), error counters by the thread calling update()
+    StatCounter rxBytes, rxFrames, rxPayloadBytes, rxEscapes, resyncs, skippedBytes;
+    StatCounter txBytes, txFrames, txPayloadBytes, txEscapes;
+    StatCounter errorCounts[ErrorTypeCount];
+    #ifdef OF_VERSION_MAJOR
+    std::atomic<int> maxBacklog;
+    struct TopicCounters {
+        StatCounter rxPackets, rxBytes, txPackets, txBytes;
+    };
+    TopicCounters topicCounters[256];
+    #else
+    int maxBacklog;
+    #endif
+    bool skippingBytes; // the decoder is dropping bytes before a header (one resync)
+#endif
+#ifdef OF_VERSION_MAJOR
+    std::atomic<uint16_t> nextTransferId; // sendLarge() may run on several threads
+#else
+    uint16_t nextTransferId;
+#endif
+    
+    // Sending side of a delta encoded topic
+    struct DeltaSender {
+        uint8_t topicId;
+        bool valid;             // last holds what the receiver holds
+        bool keyframeRequested;
+        uint8_t sequence;
+        uint16_t keyframeInterval;
+        uint16_t sinceKeyframe; // delta frames since the last keyframe
+        uint16_t length;
+        uint16_t capacity;
+        uint8_t* last;          // previous payload sent
+    };
+#ifdef OF_VERSION_MAJOR
+    std::unique_ptr<DeltaSender> deltaSenders[256];
+    std::mutex deltaMutex; // held while a delta frame is encoded and queued, senders may run on several threads
+    
+    // Receiving side: the last payload rebuilt for each topic, touched only on the thread calling update()
+    struct DeltaReceiver {
+        std::vector<uint8_t> last;
+        uint8_t sequence;
+        bool valid;
+        uint16_t missed; // frames dropped while waiting for a keyframe
+    };
+    std::unique_ptr<DeltaReceiver> deltaReceivers[256];
+#else
+    DeltaSender deltaSenders[MAX_DELTA_TOPICS];
+    uint8_t deltaSenderCount;
+#endif
+    
+    // Sending side of a reliable topic
+    struct ReliableSlot {
+        uint16_t sequence;
+        uint16_t length;
+        uint32_t sentMillis;
+        uint8_t retries;
+        bool pending; // sent and not acknowledged yet
+    };
+    struct ReliableSender {
+        uint8_t topicId;
+        uint8_t window;
+        uint16_t session;
+        uint16_t base;     // oldest sequence not acknowledged yet
+        uint16_t next;     // sequence of the next new packet
+        uint16_t srtt;     // 0: no sample yet
+        uint16_t rttvar;
+        uint16_t rto;
+        uint16_t capacity;
+        ReliableSlot* slots; // indexed by sequence % window
+        uint8_t* data;       // window * capacity payload bytes, same index
+        ReliableStats stats;
+    };
+    // Receiving side, touched only on the thread calling update()
+    struct ReliableReceiver {
+        uint8_t topicId;
+        uint16_t session;
+        uint16_t cumulative; // next sequence expected in order
+        uint32_t selective;  // bit i: cumulative + 1 + i arrived
+        uint32_t duplicates;
+        bool valid;          // a frame of session has arrived
+    };
+#ifdef OF_VERSION_MAJOR
+    std::unique_ptr<ReliableSender> reliableSenders[256];
+    std::unique_ptr<ReliableReceiver> reliableReceivers[256];
+    std::atomic<size_t> reliableSenderCount;
+    std::mutex reliableMutex; // held while a reliable topic's window is changed and its frames are queued
+#else
+    ReliableSender reliableSenders[MAX_RELIABLE_TOPICS];
+    uint8_t reliableSenderCount;
+    ReliableReceiver reliableReceivers[MAX_RELIABLE_TOPICS];
+    uint8_t reliableReceiverCount;
+#endif
+    
+#ifdef OF_VERSION_MAJOR
+    std::shared_ptr<Transport> transport;
+    
+    // subscribe() handlers indexed by topicId
+    std::function<void(const ofxBinaryPacket&)> subscribers[256];
+    
+    // Streamed frame being decoded. receivedData only stages escaped bytes.
+    std::unique_ptr<StreamHandler> streamHandlers[256];
+    StreamHandler* activeStream;
+    uint32_t streamChecksumState;
+    uint16_t streamStagedLength;
+    
+    // Entry passed from the reader thread to update()
+    struct ReceivedSlot {
+        bool isError;
+        ErrorType error;
+        uint8_t topicId;
+        uint16_t length;
+        uint64_t arrivalMicros;
+        alignas(ofxBinaryPacket::dataAlignment) uint8_t data[MaxPacket];
+    };
+    
+    std::thread receiveThread;
+    bool receiveThreaded; // decoded packets go to the queue (only changed while the thread is not running)
+    std::atomic<bool> receiveThreadRunning;
+    QueueFullPolicy receiveQueuePolicy;
+    ofxBinarySpscQueue<ReceivedSlot> receiveQueue;
+    std::atomic<uint64_t> receiveQueueQueued;
+    std::atomic<uint64_t> receiveQueueDropped;
+    std::atomic<size_t> receiveQueueHighWaterMark;
+    
+    // Worker pool running the handlers (setExecutor())
+    std::shared_ptr<ofxBinaryCommunicatorExecutor> executor;
+    ofxBinaryCommunicatorExecutor::Port* executorPort;
+    
+    // Encoded frame passed from senders to the writer thread
+    struct SendSlot {
+        size_t length;
+        uint8_t topicId;
+        uint16_t payloadLength;
+        uint16_t escapes;
+        uint8_t frame[MaxFrameHeaderSize + MaxPacket * 2];
+    };
+    
+    std::thread sendThread;
+    bool sendThreaded; // sends go to the queue (only changed while the thread is not running)
+    std::atomic<bool> sendThreadRunning;
+    BackpressurePolicy sendQueuePolicy;
+    ofxBinaryMpmcQueue<SendSlot> sendQueues[3]; // by SendPriority, unused ones unallocated
+    SendPriority sendPriorities[256];
+    uint32_t sendWeights[3];
+    int64_t sendDeficits[3]; // bytes Normal and Bulk may still write this round (writer thread)
+    SendPriority sendTurn;
+    std::mutex sendMutex;
+    std::condition_variable sendCondition;
+    std::atomic<int64_t> sendPending; // queued but not yet written
+    std::atomic<uint64_t> sendQueueQueued;
+    std::atomic<uint64_t> sendQueueDropped;
+    std::atomic<size_t> sendQueueHighWaterMark;
+    std::atomic<uint32_t> writeFailures; // frames cut short by the transport, reported as WriteFailed by update()
+    
+    // Pending slot of a coalesced topic (setCoalescing())
+    struct CoalescedTopic {
+        uint64_t intervalMicros; // 0: no rate limit
+        uint64_t nextSendMicros;
+        CoalesceStats stats;
+        uint16_t length;
+        alignas(ofxBinaryPacket::dataAlignment) uint8_t data[MaxPacket];
+    };
+    std::unique_ptr<CoalescedTopic> coalescedTopics[256];
+    std::atomic<size_t> coalescedTopicCount;
+    mutable std::mutex coalesceMutex; // held while a coalesced packet is stored or written
+    size_t coalescingWatermark;
+    
+    // sendLarge() payloads being reassembled, touched only on the thread calling update()
+    struct LargeTransfer {
+        uint8_t topicId;
+        uint16_t transferId;
+        uint16_t totalLength;
+        uint16_t receivedLength;
+        uint64_t lastReceivedMillis;
+        uint64_t arrivalMicros; // of the first fragment
+        std::vector<uint8_t> buffer;
+    };
+    std::vector<LargeTransfer> largeTransfers;
+    std::vector<std::vector<uint8_t>> largeBufferPool; // buffers of finished transfers, reused
+    uint64_t largeTransferTimeoutMillis;
+    size_t maxLargeTransfers;
+    
+    // Round trips of sendPing()
+    ofxBinaryLatencyHistogram pingHistogram;
+    mutable std::mutex pingMutex; // the decoding thread records, any thread reads
+    std::atomic<uint32_t> nextPingSequence;
+    std::atomic<uint64_t> pingsSent;
+    uint64_t pingIntervalMicros; // 0: no periodic ping
+    uint64_t nextPingMicros;
+    ofxBinaryClockSync clockSync; // fed by the Pongs, under pingMutex
+    
+    // Decoding thread: when the current read returned, and when the current frame's header was read
+    uint64_t readMicros;
+    uint64_t frameArrivalMicros;
+#endif
 };
 
+// The communicator most code uses: MAX_PACKET_SIZE, negotiable checksum, any transport
+typedef ofxBasicBinaryCommunicator<> ofxBinaryCommunicator;
+
 #include "ofxBinaryCommunicatorTopics.h"
 #include "OscLikeMessage.h"
+#include "ofxBinaryCommunicatorImpl.h"
 #include "ofxBinaryCommunicatorTool.h"
+#include "ofxBinaryCommunicatorHub.h"
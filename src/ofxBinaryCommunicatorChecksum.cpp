@@ -0,0 +1,350 @@
+#include "ofxBinaryCommunicatorChecksum.h"
+#include <string.h>
+
+#if defined(__AVR__)
+    // Keep the table in flash
+    #include <avr/pgmspace.h>
+    #define CHECKSUM_TABLE_PROGMEM PROGMEM
+    #define CHECKSUM_TABLE_READ16(table, index) pgm_read_word(&(table)[index])
+#else
+    #define CHECKSUM_TABLE_PROGMEM
+    #define CHECKSUM_TABLE_READ16(table, index) ((table)[index])
+#endif
+
+// SIMD paths (host only). SSE4.2 and AVX2 are picked at runtime, so the build doesn't need -mavx2.
+#if !defined(ARDUINO) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define CHECKSUM_HAS_X86_DISPATCH
+    #define CHECKSUM_TARGET_SSE42 __attribute__((target("sse4.2")))
+    #define CHECKSUM_TARGET_AVX2 __attribute__((target("avx2")))
+#elif !defined(ARDUINO) && defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+    #include <immintrin.h>
+    #define CHECKSUM_HAS_X86_DISPATCH
+    #define CHECKSUM_TARGET_SSE42
+    #define CHECKSUM_TARGET_AVX2
+#endif
+#if defined(CHECKSUM_HAS_X86_DISPATCH) && (defined(__SSE2__) || defined(_M_X64))
+    #define CHECKSUM_HAS_SSE2_PATH
+#endif
+#if !defined(ARDUINO) && defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define CHECKSUM_HAS_NEON_PATH
+#endif
+#if !defined(ARDUINO) && defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define CHECKSUM_HAS_ARM_CRC32_PATH
+#endif
+
+#if defined(CHECKSUM_HAS_X86_DISPATCH)
+// Checked once on first use
+struct CpuFeatures {
+    bool sse42;
+    bool avx2;
+    
+    CpuFeatures() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        sse42 = (info[2] & (1 << 20)) != 0;
+        // AVX needs OS support for the ymm registers (OSXSAVE and XCR0)
+        bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        sse42 = __builtin_cpu_supports("sse4.2");
+        avx2 = __builtin_cpu_supports("avx2");
+#endif
+    }
+};
+
+static const CpuFeatures& getCpuFeatures() {
+    static const CpuFeatures features;
+    return features;
+}
+#endif
+
+// Fletcher16
+//
+// Over a block of n bytes d[0..n-1]:
+//   sum1 += d[0] + ... + d[n-1]
+//   sum2 += n * sum1 + n * d[0] + (n - 1) * d[1] + ... + 1 * d[n-1]
+// The SIMD paths add up the plain and weighted byte sums of each block in 32bit lanes.
+// Both sums wrap at 8 bits and 2^32 is a multiple of 256, so the lanes never need reducing
+// and the result is bit-identical to the byte loop.
+static inline uint32_t fletcher16AddBlocks(uint32_t state, size_t blockSize, size_t blocks,
+                                           uint32_t byteSum, uint32_t prefixSum, uint32_t weightedSum) {
+    // prefixSum: sum of byteSum before each block
+    uint32_t sum1 = state & 0xFF;
+    uint32_t sum2 = state >> 8;
+    sum2 += (uint32_t)(blockSize * blocks) * sum1 + (uint32_t)blockSize * prefixSum + weightedSum;
+    sum1 += byteSum;
+    return ((sum2 & 0xFF) << 8) | (sum1 & 0xFF);
+}
+
+#if defined(CHECKSUM_HAS_X86_DISPATCH)
+CHECKSUM_TARGET_AVX2
+static uint32_t fletcher16Avx2(uint32_t state, const uint8_t*& data, size_t& length) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                             16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    __m256i byteSums = zero;
+    __m256i prefixSums = zero;
+    __m256i weightedSums = zero;
+    size_t blocks = length / 32;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 32));
+        prefixSums = _mm256_add_epi32(prefixSums, byteSums);
+        byteSums = _mm256_add_epi32(byteSums, _mm256_sad_epu8(v, zero));
+        // Byte pairs are at most 255 * (32 + 31), so maddubs can't saturate
+        weightedSums = _mm256_add_epi32(weightedSums, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+    }
+    
+    uint32_t sums[3];
+    __m256i all[3] = {byteSums, prefixSums, weightedSums};
+    for (int k = 0; k < 3; ++k) {
+        __m128i x = _mm_add_epi32(_mm256_castsi256_si128(all[k]), _mm256_extracti128_si256(all[k], 1));
+        x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4E));
+        x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+        sums[k] = (uint32_t)_mm_cvtsi128_si32(x);
+    }
+    data += blocks * 32;
+    length -= blocks * 32;
+    return fletcher16AddBlocks(state, 32, blocks, sums[0], sums[1], sums[2]);
+}
+#endif
+
+#if defined(CHECKSUM_HAS_SSE2_PATH)
+static uint32_t fletcher16Sse2(uint32_t state, const uint8_t*& data, size_t& length) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightsLow = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i weightsHigh = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    __m128i byteSums = zero;
+    __m128i prefixSums = zero;
+    __m128i weightedSums = zero;
+    size_t blocks = length / 16;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+        prefixSums = _mm_add_epi32(prefixSums, byteSums);
+        byteSums = _mm_add_epi32(byteSums, _mm_sad_epu8(v, zero));
+        __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weightsLow);
+        __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weightsHigh);
+        weightedSums = _mm_add_epi32(weightedSums, _mm_add_epi32(low, high));
+    }
+    
+    uint32_t sums[3];
+    __m128i all[3] = {byteSums, prefixSums, weightedSums};
+    for (int k = 0; k < 3; ++k) {
+        __m128i x = _mm_add_epi32(all[k], _mm_shuffle_epi32(all[k], 0x4E));
+        x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+        sums[k] = (uint32_t)_mm_cvtsi128_si32(x);
+    }
+    data += blocks * 16;
+    length -= blocks * 16;
+    return fletcher16AddBlocks(state, 16, blocks, sums[0], sums[1], sums[2]);
+}
+#endif
+
+#if defined(CHECKSUM_HAS_NEON_PATH)
+static uint32_t fletcher16Neon(uint32_t state, const uint8_t*& data, size_t& length) {
+    static const uint8_t weightValues[16] = {16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+    const uint8x8_t weightsLow = vld1_u8(weightValues);
+    const uint8x8_t weightsHigh = vld1_u8(weightValues + 8);
+    uint32x4_t byteSums = vdupq_n_u32(0);
+    uint32x4_t prefixSums = vdupq_n_u32(0);
+    uint32x4_t weightedSums = vdupq_n_u32(0);
+    size_t blocks = length / 16;
+    for (size_t i = 0; i < blocks; ++i) {
+        uint8x16_t v = vld1q_u8(data + i * 16);
+        prefixSums = vaddq_u32(prefixSums, byteSums);
+        byteSums = vpadalq_u16(byteSums, vpaddlq_u8(v));
+        uint16x8_t weighted = vmull_u8(vget_low_u8(v), weightsLow);
+        weighted = vmlal_u8(weighted, vget_high_u8(v), weightsHigh);
+        weightedSums = vpadalq_u16(weightedSums, weighted);
+    }
+    
+    data += blocks * 16;
+    length -= blocks * 16;
+    return fletcher16AddBlocks(state, 16, blocks, vaddvq_u32(byteSums), vaddvq_u32(prefixSums), vaddvq_u32(weightedSums));
+}
+#endif
+
+uint32_t ofxBinaryFletcher16::update(uint32_t state, const uint8_t* data, size_t length) {
+#if defined(CHECKSUM_HAS_X86_DISPATCH)
+    if (length >= 64 && getCpuFeatures().avx2) state = fletcher16Avx2(state, data, length);
+#endif
+#if defined(CHECKSUM_HAS_SSE2_PATH)
+    if (length >= 16) state = fletcher16Sse2(state, data, length);
+#elif defined(CHECKSUM_HAS_NEON_PATH)
+    if (length >= 16) state = fletcher16Neon(state, data, length);
+#endif
+    
+    // 16bit Fletcher's Checksum (8bit sums, wrapping)
+    uint8_t sum1 = state & 0xFF;
+    uint8_t sum2 = state >> 8;
+    
+    while (length--) {
+        sum1 += *data++;
+        sum2 += sum1;
+    }
+    
+    return ((uint32_t)sum2 << 8) | sum1;
+}
+
+// CRC16
+static const uint16_t crc16Table[256] CHECKSUM_TABLE_PROGMEM = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+uint32_t ofxBinaryCRC16::update(uint32_t state, const uint8_t* data, size_t length) {
+    uint16_t crc = state;
+    while (length--) {
+        crc = (crc << 8) ^ CHECKSUM_TABLE_READ16(crc16Table, ((crc >> 8) ^ *data++) & 0xFF);
+    }
+    return crc;
+}
+
+// CRC32C
+static const uint32_t crc32cPolynomial = 0x82F63B78; // reflected 0x1EDC6F41
+
+#if defined(ARDUINO)
+// Bitwise: no table in RAM or flash
+static uint32_t crc32cSoftware(uint32_t crc, const uint8_t* data, size_t length) {
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (crc32cPolynomial & (0 - (crc & 1)));
+        }
+    }
+    return crc;
+}
+#else
+// Slicing-by-8: eight bytes per iteration with 8KB of tables
+struct Crc32cTables {
+    uint32_t table[8][256];
+    
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc32cPolynomial & (0 - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                uint32_t previous = table[slice - 1][i];
+                table[slice][i] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+static uint32_t crc32cSoftware(uint32_t crc, const uint8_t* data, size_t length) {
+    static const Crc32cTables tables;
+    const uint32_t (*t)[256] = tables.table;
+    
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (length >= 8) {
+        uint32_t low, high;
+        memcpy(&low, data, 4);
+        memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+            ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        data += 8;
+        length -= 8;
+    }
+#endif
+    while (length--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+#endif
+
+#if defined(CHECKSUM_HAS_X86_DISPATCH)
+CHECKSUM_TARGET_SSE42
+static uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t length) {
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    while (length >= 4) {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        crc = _mm_crc32_u32(crc, value);
+        data += 4;
+        length -= 4;
+    }
+    while (length--) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
+#if defined(CHECKSUM_HAS_ARM_CRC32_PATH)
+static uint32_t crc32cArm(uint32_t crc, const uint8_t* data, size_t length) {
+    while (length >= 8) {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        crc = __crc32cd(crc, value);
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32cb(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
+uint32_t ofxBinaryCRC32C::update(uint32_t state, const uint8_t* data, size_t length) {
+#if defined(CHECKSUM_HAS_X86_DISPATCH)
+    if (getCpuFeatures().sse42) return crc32cSse42(state, data, length);
+#elif defined(CHECKSUM_HAS_ARM_CRC32_PATH)
+    return crc32cArm(state, data, length);
+#endif
+    return crc32cSoftware(state, data, length);
+}
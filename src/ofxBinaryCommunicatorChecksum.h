@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Integrity check carried in the frame header.
+// Both ends must use the same one (see ofxBinaryCommunicator::requestChecksumType()).
+enum class ofxBinaryChecksumType : uint8_t {
+    Fletcher16 = 0, // 2 bytes, the original wire format
+    CRC16 = 1,      // 2 bytes, CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+    CRC32C = 2      // 4 bytes, CRC-32C Castagnoli (SSE4.2/ARMv8 crc32 instructions when available)
+};
+
+// Checksum used until something else is negotiated
+#ifndef DEFAULT_CHECKSUM_TYPE
+#define DEFAULT_CHECKSUM_TYPE ofxBinaryChecksumType::Fletcher16
+#endif
+
+// Checksum engines. Each one can be computed in pieces:
+//   uint32_t state = begin();
+//   state = update(state, data, length); // as many times as needed
+//   uint32_t checksum = finish(state);
+struct ofxBinaryFletcher16 {
+    static const ofxBinaryChecksumType type = ofxBinaryChecksumType::Fletcher16;
+    static const uint8_t size = 2;
+    static uint32_t begin() { return 0xFFFF; }
+    static uint32_t update(uint32_t state, const uint8_t* data, size_t length);
+    static uint32_t finish(uint32_t state) { return state; }
+    static uint32_t calculate(const uint8_t* data, size_t length) { return finish(update(begin(), data, length)); }
+};
+
+struct ofxBinaryCRC16 {
+    static const ofxBinaryChecksumType type = ofxBinaryChecksumType::CRC16;
+    static const uint8_t size = 2;
+    static uint32_t begin() { return 0xFFFF; }
+    static uint32_t update(uint32_t state, const uint8_t* data, size_t length);
+    static uint32_t finish(uint32_t state) { return state; }
+    static uint32_t calculate(const uint8_t* data, size_t length) { return finish(update(begin(), data, length)); }
+};
+
+struct ofxBinaryCRC32C {
+    static const ofxBinaryChecksumType type = ofxBinaryChecksumType::CRC32C;
+    static const uint8_t size = 4;
+    static uint32_t begin() { return 0xFFFFFFFF; }
+    static uint32_t update(uint32_t state, const uint8_t* data, size_t length);
+    static uint32_t finish(uint32_t state) { return state ^ 0xFFFFFFFF; }
+    static uint32_t calculate(const uint8_t* data, size_t length) { return finish(update(begin(), data, length)); }
+};
+
+// Same interface, selected at runtime
+class ofxBinaryChecksum {
+public:
+    static const uint8_t maxSize = 4;
+
+    static bool isSupported(uint8_t type) {
+        return type <= (uint8_t)ofxBinaryChecksumType::CRC32C;
+    }
+
+    static constexpr uint8_t getSize(ofxBinaryChecksumType type) {
+        return type == ofxBinaryChecksumType::CRC32C ? ofxBinaryCRC32C::size : 2;
+    }
+
+    static uint32_t begin(ofxBinaryChecksumType type) {
+        switch (type) {
+            case ofxBinaryChecksumType::CRC16: return ofxBinaryCRC16::begin();
+            case ofxBinaryChecksumType::CRC32C: return ofxBinaryCRC32C::begin();
+            default: return ofxBinaryFletcher16::begin();
+        }
+    }
+
+    static uint32_t update(ofxBinaryChecksumType type, uint32_t state, const uint8_t* data, size_t length) {
+        switch (type) {
+            case ofxBinaryChecksumType::CRC16: return ofxBinaryCRC16::update(state, data, length);
+            case ofxBinaryChecksumType::CRC32C: return ofxBinaryCRC32C::update(state, data, length);
+            default: return ofxBinaryFletcher16::update(state, data, length);
+        }
+    }
+
+    static uint32_t finish(ofxBinaryChecksumType type, uint32_t state) {
+        switch (type) {
+            case ofxBinaryChecksumType::CRC16: return ofxBinaryCRC16::finish(state);
+            case ofxBinaryChecksumType::CRC32C: return ofxBinaryCRC32C::finish(state);
+            default: return ofxBinaryFletcher16::finish(state);
+        }
+    }
+
+    static uint32_t calculate(ofxBinaryChecksumType type, const uint8_t* data, size_t length) {
+        return finish(type, update(type, begin(type), data, length));
+    }
+};
+
+// How ofxBasicBinaryCommunicator calls its Checksum parameter.
+// A fixed engine ignores the type argument, so it is inlined and the link can't switch to another type.
+template<typename Engine>
+struct ofxBinaryChecksumTraits {
+    static const uint8_t maxSize = Engine::size;
+    static constexpr ofxBinaryChecksumType defaultType() { return Engine::type; }
+    static bool isSupported(uint8_t type) { return type == (uint8_t)Engine::type; }
+    static constexpr uint8_t getSize(ofxBinaryChecksumType) { return Engine::size; }
+    static uint32_t begin(ofxBinaryChecksumType) { return Engine::begin(); }
+    static uint32_t update(ofxBinaryChecksumType, uint32_t state, const uint8_t* data, size_t length) {
+        return Engine::update(state, data, length);
+    }
+    static uint32_t finish(ofxBinaryChecksumType, uint32_t state) { return Engine::finish(state); }
+    static uint32_t calculate(ofxBinaryChecksumType, const uint8_t* data, size_t length) {
+        return Engine::calculate(data, length);
+    }
+};
+
+// Any type, negotiated at runtime
+template<>
+struct ofxBinaryChecksumTraits<ofxBinaryChecksum> : ofxBinaryChecksum {
+    static constexpr ofxBinaryChecksumType defaultType() { return DEFAULT_CHECKSUM_TYPE; }
+};
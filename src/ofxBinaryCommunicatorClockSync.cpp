@@ -0,0 +1,94 @@
+#include "ofxBinaryCommunicator.h"
+
+#ifdef OF_VERSION_MAJOR
+
+#include <algorithm>
+
+// Exchanges closer together than this give no usable drift
+static const double minDriftSpanMicros = 1000000;
+
+void ofxBinaryClockSync::reset() {
+    sampleCount = 0;
+    nextSample = 0;
+    latestRemoteMicros = 0;
+    estimate.valid = false;
+    estimate.referenceHostMicros = 0;
+    estimate.offsetMicros = 0;
+    estimate.drift = 0;
+    estimate.minRoundTripMicros = 0;
+    estimate.sampleCount = 0;
+}
+
+void ofxBinaryClockSync::addSample(uint64_t sentHostMicros, uint64_t receivedHostMicros, uint64_t remoteMicros) {
+    if (receivedHostMicros < sentHostMicros) return;
+    // The remote clock went back: it restarted, so what we know of it is void
+    if (sampleCount > 0 && remoteMicros < latestRemoteMicros) {
+        reset();
+    }
+    latestRemoteMicros = remoteMicros;
+
+    Sample& sample = samples[nextSample];
+    sample.roundTrip = (uint32_t)std::min<uint64_t>(receivedHostMicros - sentHostMicros, UINT32_MAX);
+    sample.hostMicros = sentHostMicros + (receivedHostMicros - sentHostMicros) / 2;
+    sample.offset = (int64_t)(remoteMicros - sample.hostMicros);
+    nextSample = (nextSample + 1) % SampleCount;
+    if (sampleCount < SampleCount) sampleCount++;
+    updateEstimate();
+}
+
+void ofxBinaryClockSync::updateEstimate() {
+    // The exchanges with the shortest round trips had the least room for asymmetric delay
+    size_t order[SampleCount] = {};
+    for (size_t i = 0; i < sampleCount; ++i) order[i] = i;
+    std::sort(order, order + sampleCount, [this](size_t a, size_t b) { return samples[a].roundTrip < samples[b].roundTrip; });
+    size_t used = std::max<size_t>(1, sampleCount / 4);
+
+    // Fit offset = a + drift * (host - reference) around the mean, which keeps the doubles small
+    const Sample& base = samples[order[0]];
+    double meanHost = 0, meanOffset = 0;
+    for (size_t i = 0; i < used; ++i) {
+        const Sample& s = samples[order[i]];
+        meanHost += (double)(int64_t)(s.hostMicros - base.hostMicros);
+        meanOffset += (double)(s.offset - base.offset);
+    }
+    meanHost /= used;
+    meanOffset /= used;
+
+    double covariance = 0, variance = 0, minHost = 0, maxHost = 0;
+    for (size_t i = 0; i < used; ++i) {
+        const Sample& s = samples[order[i]];
+        double host = (double)(int64_t)(s.hostMicros - base.hostMicros);
+        double dx = host - meanHost;
+        covariance += dx * ((double)(s.offset - base.offset) - meanOffset);
+        variance += dx * dx;
+        minHost = std::min(minHost, host);
+        maxHost = std::max(maxHost, host);
+    }
+    // Keep the last drift until the exchanges span long enough to measure it
+    if (used >= 2 && maxHost - minHost >= minDriftSpanMicros && variance > 0) {
+        estimate.drift = covariance / variance;
+    }
+
+    estimate.valid = true;
+    estimate.referenceHostMicros = base.hostMicros + (int64_t)meanHost;
+    estimate.offsetMicros = (double)base.offset + meanOffset;
+    estimate.minRoundTripMicros = base.roundTrip;
+    estimate.sampleCount = sampleCount;
+}
+
+// remote = host + offset + drift * (host - reference), solved for host
+uint64_t ofxBinaryClockSync::toHostMicros(uint64_t remoteMicros) const {
+    if (!estimate.valid) return remoteMicros;
+    double remote = (double)(int64_t)(remoteMicros - estimate.referenceHostMicros);
+    double host = (remote - estimate.offsetMicros) / (1 + estimate.drift);
+    return estimate.referenceHostMicros + (int64_t)(host < 0 ? host - 0.5 : host + 0.5);
+}
+
+uint64_t ofxBinaryClockSync::toRemoteMicros(uint64_t hostMicros) const {
+    if (!estimate.valid) return hostMicros;
+    double host = (double)(int64_t)(hostMicros - estimate.referenceHostMicros);
+    double remote = host * (1 + estimate.drift) + estimate.offsetMicros;
+    return estimate.referenceHostMicros + (int64_t)(remote < 0 ? remote - 0.5 : remote + 0.5);
+}
+
+#endif
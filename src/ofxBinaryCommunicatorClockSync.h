@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Offset and drift of the other end's clock, estimated from ping exchanges like NTP (openFrameworks only).
+// Each exchange gives the remote time at the moment it answered and the local times the request left
+// and the answer arrived. Assuming both legs took as long, the remote clock read remote at the midpoint.
+// Queuing on one leg breaks that assumption by up to half the round trip, so only the quarter of recent
+// exchanges with the shortest round trips is used; a least squares line through them gives the offset
+// and the drift. Times are in microseconds. Not thread safe.
+class ofxBinaryClockSync {
+public:
+    static const size_t SampleCount = 32;
+
+    struct Estimate {
+        bool valid;                  // at least one exchange
+        uint64_t referenceHostMicros;
+        double offsetMicros;         // remote minus local at referenceHostMicros
+        double drift;                // remote seconds gained per local second
+        uint32_t minRoundTripMicros; // of the exchanges in use
+        size_t sampleCount;
+    };
+
+    ofxBinaryClockSync() { reset(); }
+
+    void addSample(uint64_t sentHostMicros, uint64_t receivedHostMicros, uint64_t remoteMicros);
+    void reset();
+
+    const Estimate& getEstimate() const { return estimate; }
+    // Remote time of the latest exchange
+    uint64_t getLatestRemoteMicros() const { return latestRemoteMicros; }
+    uint64_t toHostMicros(uint64_t remoteMicros) const;
+    uint64_t toRemoteMicros(uint64_t hostMicros) const;
+
+private:
+    struct Sample {
+        uint64_t hostMicros; // midpoint of the exchange
+        int64_t offset;      // remote minus hostMicros
+        uint32_t roundTrip;
+    };
+
+    void updateEstimate();
+
+    Sample samples[SampleCount];
+    size_t sampleCount;
+    size_t nextSample;
+    uint64_t latestRemoteMicros;
+    Estimate estimate;
+};
+
+#endif
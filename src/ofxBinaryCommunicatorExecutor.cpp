@@ -0,0 +1,224 @@
+#include "ofxBinaryCommunicator.h"
+
+#ifdef OF_VERSION_MAJOR
+
+#include <algorithm>
+#include <chrono>
+
+// Packets a worker runs from one strand before giving the others a turn
+static const size_t strandBatchSize = 32;
+
+ofxBinaryCommunicatorExecutor::ofxBinaryCommunicatorExecutor(size_t numThreads, size_t poolSize, size_t maxPacketSize, QueueFullPolicy policy)
+    : policy(policy), nextWorker(0), scheduledCount(0), running(true), submitted(0), executed(0), dropped(0), steals(0),
+      highWaterMark(0), handlerNanos(0), maxHandlerNanos(0) {
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (poolSize == 0) poolSize = 1;
+
+    // Keep every slot aligned like the receive buffers, so view() works on worker threads too
+    const size_t alignment = ofxBinaryPacket::dataAlignment;
+    slotStride = std::max<size_t>(1, (maxPacketSize + alignment - 1) / alignment) * alignment;
+    slots.resize(poolSize);
+    slotData.reset(new uint8_t[slotStride * poolSize]);
+    freeSlots.allocate(poolSize);
+    for (uint32_t i = 0; i < poolSize; ++i) {
+        freeSlots.push([i](uint32_t& slot) { slot = i; });
+    }
+
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers[i]->thread = std::thread(&ofxBinaryCommunicatorExecutor::workerFunction, this, i);
+    }
+}
+
+ofxBinaryCommunicatorExecutor::~ofxBinaryCommunicatorExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+ofxBinaryCommunicatorExecutor::Stats ofxBinaryCommunicatorExecutor::getStats() const {
+    Stats stats;
+    stats.executed = executed;
+    stats.submitted = submitted;
+    stats.dropped = dropped;
+    stats.steals = steals;
+    stats.depth = (size_t)(stats.submitted - std::min(stats.submitted, stats.executed));
+    stats.highWaterMark = highWaterMark;
+    stats.handlerSeconds = handlerNanos * 1e-9;
+    stats.maxHandlerSeconds = maxHandlerNanos * 1e-9;
+    return stats;
+}
+
+ofxBinaryCommunicatorExecutor::Port* ofxBinaryCommunicatorExecutor::addPort(Handler handler) {
+    std::unique_ptr<Port> port(new Port());
+    port->handler = handler;
+    port->pending = 0;
+    Port* p = port.get();
+    std::lock_guard<std::mutex> lock(portsMutex);
+    ports.push_back(std::move(port));
+    return p;
+}
+
+void ofxBinaryCommunicatorExecutor::removePort(Port* port) {
+    if (port == nullptr) return;
+    while (port->pending > 0) {
+        ofSleepMillis(1);
+    }
+    std::lock_guard<std::mutex> lock(portsMutex);
+    for (auto it = ports.begin(); it != ports.end(); ++it) {
+        if (it->get() == port) {
+            ports.erase(it);
+            return;
+        }
+    }
+}
+
+bool ofxBinaryCommunicatorExecutor::submit(Port* port, const ofxBinaryPacket& packet) {
+    // One producer at a time for the port's strands
+    std::lock_guard<std::mutex> lock(port->submitMutex);
+
+    uint32_t slot = 0;
+    auto take = [&slot](uint32_t& index) { slot = index; };
+    bool taken = freeSlots.pop(take);
+    while (!taken && policy == QueueFullPolicy::Block && running) {
+        ofSleepMillis(1);
+        taken = freeSlots.pop(take);
+    }
+    if (!taken) {
+        dropped++;
+        return false;
+    }
+
+    slots[slot].topicId = packet.topicId;
+    slots[slot].length = packet.length;
+    slots[slot].arrivalMicros = packet.arrivalMicros;
+    if (packet.length > slotStride) {
+        slots[slot].large.assign(packet.data, packet.data + packet.length);
+    }
+    else {
+        memcpy(getSlotData(slot), packet.data, packet.length);
+    }
+
+    Strand* strand = port->strands[packet.topicId].get();
+    if (strand == nullptr) {
+        strand = new Strand();
+        strand->port = port;
+        // Can't overflow: a strand never holds more than the pool
+        strand->queue.allocate(slots.size());
+        strand->scheduled = false;
+        port->strands[packet.topicId].reset(strand);
+    }
+
+    port->pending++;
+    *strand->queue.beginPush() = slot;
+    strand->queue.commitPush();
+
+    uint64_t count = ++submitted;
+    size_t depth = (size_t)(count - std::min(count, executed.load()));
+    if (depth > highWaterMark) {
+        highWaterMark = depth;
+    }
+
+    if (!strand->scheduled.exchange(true)) {
+        schedule(strand);
+    }
+    return true;
+}
+
+void ofxBinaryCommunicatorExecutor::schedule(Strand* strand) {
+    // The queued strand keeps its port alive until run() is done with it
+    strand->port->pending++;
+    Worker& worker = *workers[nextWorker++ % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.strands.push_back(strand);
+    }
+    scheduledCount++;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+// Own queue first (oldest first), then steal the newest strand of another worker
+ofxBinaryCommunicatorExecutor::Strand* ofxBinaryCommunicatorExecutor::takeStrand(size_t self) {
+    Strand* strand = nullptr;
+    {
+        Worker& worker = *workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.strands.empty()) {
+            strand = worker.strands.front();
+            worker.strands.pop_front();
+        }
+    }
+    for (size_t i = 1; strand == nullptr && i < workers.size(); ++i) {
+        Worker& victim = *workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.strands.empty()) {
+            strand = victim.strands.back();
+            victim.strands.pop_back();
+            steals++;
+        }
+    }
+    if (strand != nullptr) {
+        scheduledCount--;
+    }
+    return strand;
+}
+
+void ofxBinaryCommunicatorExecutor::run(Strand* strand) {
+    Port* port = strand->port;
+    size_t count = 0;
+    uint32_t* index;
+    while (count < strandBatchSize && (index = strand->queue.front()) != nullptr) {
+        uint32_t slot = *index;
+        strand->queue.pop();
+
+        auto start = std::chrono::steady_clock::now();
+        ofxBinaryPacket packet(slots[slot].topicId, slots[slot].length, getSlotData(slot));
+        packet.arrivalMicros = slots[slot].arrivalMicros;
+        port->handler(packet);
+        uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        if (slots[slot].length > slotStride) {
+            std::vector<uint8_t>().swap(slots[slot].large);
+        }
+        freeSlots.push([slot](uint32_t& free) { free = slot; });
+        handlerNanos += nanos;
+        uint64_t max = maxHandlerNanos;
+        while (nanos > max && !maxHandlerNanos.compare_exchange_weak(max, nanos)) {}
+        executed++;
+        count++;
+    }
+
+    // Hand the strand back. If the decoder pushed in the meantime, exactly one of us reschedules it.
+    strand->scheduled = false;
+    if (strand->queue.front() != nullptr && !strand->scheduled.exchange(true)) {
+        schedule(strand);
+    }
+    // Last access to the port: removePort() may free it from here on
+    port->pending -= count + 1;
+}
+
+void ofxBinaryCommunicatorExecutor::workerFunction(size_t self) {
+    for (;;) {
+        Strand* strand = takeStrand(self);
+        if (strand != nullptr) {
+            run(strand);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (scheduledCount > 0) continue;
+        if (!running) break;
+        wakeCondition.wait(lock);
+    }
+}
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs packet handlers on a pool of worker threads (openFrameworks only).
+// A communicator with setExecutor() copies each decoded packet into a preallocated slot and returns
+// to decoding; a worker then fires its subscribe() handlers and onReceived. A slow handler only holds
+// up its own topic, not the port.
+// Packets of the same (communicator, topic) run one at a time, in the order they arrived.
+// Different topics, and different communicators, run in parallel, so a listener that handles
+// several topics must be thread safe. Idle workers steal queued topics from busy ones.
+// One executor can be shared by any number of communicators (e.g. all the ports of a hub).
+class ofxBinaryCommunicatorExecutor {
+public:
+    typedef ofxBinaryCommunicatorBase::QueueFullPolicy QueueFullPolicy;
+
+    struct Stats {
+        uint64_t submitted;     // packets handed to the pool
+        uint64_t executed;      // packets whose handlers have returned
+        uint64_t dropped;       // discarded because every slot was in use (DropNewest)
+        uint64_t steals;        // topics a worker took from another worker's queue
+        size_t depth;           // packets waiting or running
+        size_t highWaterMark;   // max depth seen
+        double handlerSeconds;  // total time spent in handlers
+        double maxHandlerSeconds;
+    };
+
+    // numThreads 0 uses one per hardware thread. poolSize slots of maxPacketSize bytes are
+    // preallocated; when they are all in use, policy decides whether the decoding thread waits
+    // (Block) or the packet is dropped (DropNewest). A larger packet (a communicator with a
+    // larger MaxPacket, a sendLarge() payload) still takes a slot, but its bytes are copied to the heap.
+    explicit ofxBinaryCommunicatorExecutor(size_t numThreads = 0, size_t poolSize = 1024, size_t maxPacketSize = MAX_PACKET_SIZE,
+                                           QueueFullPolicy policy = QueueFullPolicy::DropNewest);
+    // Runs what is still queued, then joins the workers
+    ~ofxBinaryCommunicatorExecutor();
+
+    size_t getNumThreads() const { return workers.size(); }
+    size_t getPoolSize() const { return slots.size(); }
+    Stats getStats() const;
+
+    // Used by the communicator
+    typedef std::function<void(const ofxBinaryPacket&)> Handler;
+    struct Port;
+    Port* addPort(Handler handler);
+    // Waits until the port's queued packets have run. Don't call it from one of its handlers.
+    void removePort(Port* port);
+    // Called by the port's decoding thread, and by update() for the payloads it reassembles.
+    // Returns false if the packet was dropped.
+    bool submit(Port* port, const ofxBinaryPacket& packet);
+
+private:
+    // Packets of one (port, topic), run by one worker at a time
+    struct Strand {
+        Port* port;
+        ofxBinarySpscQueue<uint32_t> queue; // slot indices
+        std::atomic<bool> scheduled;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Strand*> strands;
+    };
+
+    struct Slot {
+        uint8_t topicId;
+        uint16_t length;
+        uint64_t arrivalMicros;
+        std::vector<uint8_t> large; // packets longer than slotStride, released after they run
+    };
+
+    uint8_t* getSlotData(uint32_t slot) { return slots[slot].length > slotStride ? slots[slot].large.data() : slotData.get() + slot * slotStride; }
+    void schedule(Strand* strand);
+    Strand* takeStrand(size_t self);
+    void run(Strand* strand);
+    void workerFunction(size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::unique_ptr<Port>> ports;
+    std::mutex portsMutex;
+
+    // Packet pool
+    std::vector<Slot> slots;
+    std::unique_ptr<uint8_t[]> slotData;
+    size_t slotStride;
+    ofxBinaryMpmcQueue<uint32_t> freeSlots;
+    QueueFullPolicy policy;
+
+    std::atomic<size_t> nextWorker;
+    std::atomic<size_t> scheduledCount; // strands sitting in worker queues
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> running;
+
+    std::atomic<uint64_t> submitted;
+    std::atomic<uint64_t> executed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> steals;
+    std::atomic<size_t> highWaterMark;
+    std::atomic<uint64_t> handlerNanos;
+    std::atomic<uint64_t> maxHandlerNanos;
+};
+
+struct ofxBinaryCommunicatorExecutor::Port {
+    Handler handler;
+    std::unique_ptr<Strand> strands[256]; // created by submit() on first use
+    std::atomic<size_t> pending;          // packets not yet run, plus queued strands
+    std::mutex submitMutex;               // the reader thread and update() may both submit
+};
+
+#endif
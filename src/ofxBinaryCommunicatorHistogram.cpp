@@ -0,0 +1,60 @@
+#include "ofxBinaryCommunicator.h"
+
+#ifdef OF_VERSION_MAJOR
+
+#include <string.h>
+
+ofxBinaryLatencyHistogram::ofxBinaryLatencyHistogram() {
+    reset();
+}
+
+void ofxBinaryLatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    sum = 0;
+    minValue = UINT32_MAX;
+    maxValue = 0;
+}
+
+void ofxBinaryLatencyHistogram::record(uint32_t value) {
+    counts[getIndex(value)]++;
+    count++;
+    sum += value;
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+}
+
+uint32_t ofxBinaryLatencyHistogram::getValueAtPercentile(double percentile) const {
+    if (count == 0) return 0;
+    if (percentile >= 100) return maxValue;
+    uint64_t target = (uint64_t)(percentile / 100 * count + 0.5);
+    if (target < 1) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            uint32_t value = getHighestValue(i);
+            return value < maxValue ? value : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+// Below SubBucketCount the index is the value. Above it, the top SubBucketBits bits of the value
+// pick one of SubBucketHalf buckets in the value's power of two.
+size_t ofxBinaryLatencyHistogram::getIndex(uint32_t value) {
+    if (value < SubBucketCount) return value;
+    int topBit = 31;
+    while (!(value & ((uint32_t)1 << topBit))) topBit--;
+    int shift = topBit - (SubBucketBits - 1);
+    return SubBucketCount + (size_t)(shift - 1) * SubBucketHalf + ((value >> shift) - SubBucketHalf);
+}
+
+uint32_t ofxBinaryLatencyHistogram::getHighestValue(size_t index) {
+    if (index < SubBucketCount) return (uint32_t)index;
+    size_t shift = (index - SubBucketCount) / SubBucketHalf + 1;
+    uint64_t sub = (index - SubBucketCount) % SubBucketHalf + SubBucketHalf;
+    return (uint32_t)(((sub + 1) << shift) - 1);
+}
+
+#endif
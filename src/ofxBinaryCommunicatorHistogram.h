@@ -0,0 +1,43 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Latency histogram with logarithmic buckets split linearly, like HdrHistogram (openFrameworks only).
+// Values 0 to 63 are exact; above that each power of two is split into 32 buckets, so a percentile is
+// within about 3% of the true value over the whole uint32_t range. record() is constant time and the
+// buckets are allocated once. Not thread safe.
+class ofxBinaryLatencyHistogram {
+public:
+    ofxBinaryLatencyHistogram();
+
+    void record(uint32_t value);
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    uint32_t getMin() const { return count > 0 ? minValue : 0; }
+    uint32_t getMax() const { return maxValue; }
+    double getMean() const { return count > 0 ? (double)sum / count : 0; }
+    // Smallest value that percentile (0 to 100) percent of the samples are at or below. 0 when empty.
+    uint32_t getValueAtPercentile(double percentile) const;
+
+private:
+    static const int SubBucketBits = 6;
+    static const uint32_t SubBucketCount = 1 << SubBucketBits;
+    static const uint32_t SubBucketHalf = SubBucketCount / 2;
+    static const size_t BucketCount = SubBucketCount + (32 - SubBucketBits) * SubBucketHalf;
+
+    static size_t getIndex(uint32_t value);
+    // Largest value that falls into the bucket
+    static uint32_t getHighestValue(size_t index);
+
+    uint64_t counts[BucketCount];
+    uint64_t count;
+    uint64_t sum;
+    uint32_t minValue;
+    uint32_t maxValue;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "ofxBinaryCommunicator.h"
+
+#ifdef OF_VERSION_MAJOR
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <unistd.h>
+#elif !defined(_WIN32)
+    #include <poll.h>
+#endif
+
+ofxBinaryCommunicatorHub::ofxBinaryCommunicatorHub() : unpolledCount(0), nextPortId(0), epollFd(-1) {
+#if defined(__linux__)
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+ofxBinaryCommunicatorHub::~ofxBinaryCommunicatorHub() {
+#if defined(__linux__)
+    if (epollFd >= 0) ::close(epollFd);
+#endif
+}
+
+int ofxBinaryCommunicatorHub::add(ofxBinaryCommunicator& communicator, int deviceId) {
+    remove(communicator);
+    auto transport = communicator.getTransport();
+    if (!transport) return -1;
+
+    std::unique_ptr<Port> port(new Port());
+    port->id = nextPortId++;
+    port->deviceId = deviceId;
+    port->fd = transport->getPollHandle();
+    port->communicator = &communicator;
+
+#if defined(__linux__)
+    if (port->fd >= 0) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = port.get();
+        if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, port->fd, &event) != 0) return -1;
+    }
+#elif defined(_WIN32)
+    port->fd = -1;
+#endif
+    if (port->fd < 0) unpolledCount++;
+
+    Port* p = port.get();
+    port->listener = communicator.onReceived.newListener([this, p](const ofxBinaryPacket& packet) {
+        ReceivedPacket received = {p->id, p->deviceId, p->communicator, packet};
+        ofNotifyEvent(onReceived, received);
+    });
+    ports.push_back(std::move(port));
+    return p->id;
+}
+
+void ofxBinaryCommunicatorHub::remove(ofxBinaryCommunicator& communicator) {
+    for (auto it = ports.begin(); it != ports.end(); ++it) {
+        if ((*it)->communicator == &communicator) {
+            unwatch(**it);
+            // Hung up ports (-2) were polled, not counted
+            if ((*it)->fd == -1) unpolledCount--;
+            ports.erase(it);
+            return;
+        }
+    }
+}
+
+// A transport closes itself when it reads the end of the stream (a TCP peer closing only sets EPOLLIN)
+bool ofxBinaryCommunicatorHub::isClosed(Port& port) {
+    auto transport = port.communicator->getTransport();
+    return !transport || !transport->isOpen();
+}
+
+void ofxBinaryCommunicatorHub::unwatch(Port& port) {
+#if defined(__linux__)
+    // Once the transport has closed its descriptor, the kernel has already taken it out of the set,
+    // and the number may belong to another file by now
+    if (port.fd >= 0 && !isClosed(port)) epoll_ctl(epollFd, EPOLL_CTL_DEL, port.fd, nullptr);
+#endif
+}
+
+size_t ofxBinaryCommunicatorHub::poll(int timeoutMillis) {
+    if (unpolledCount > 0 && (timeoutMillis < 0 || timeoutMillis > 1)) timeoutMillis = 1;
+    if (timeoutMillis < 0 || timeoutMillis > timerMillis) {
+        for (auto& port : ports) {
+            if (port->communicator->hasTimers()) {
+                timeoutMillis = timerMillis;
+                break;
+            }
+        }
+    }
+    size_t serviced = 0;
+
+#if defined(__linux__)
+    const int maxEvents = 64;
+    epoll_event events[maxEvents];
+    int n = epoll_wait(epollFd, events, maxEvents, timeoutMillis);
+    for (int i = 0; i < n; ++i) {
+        Port* port = static_cast<Port*>(events[i].data.ptr);
+        size_t bytes = port->communicator->updateReadable();
+        if (isClosed(*port) || (bytes == 0 && (events[i].events & (EPOLLHUP | EPOLLERR)))) {
+            // The other end is gone; stop waking up for it
+            unwatch(*port);
+            port->fd = -2;
+        }
+        serviced++;
+    }
+#elif !defined(_WIN32)
+    std::vector<pollfd> fds;
+    std::vector<Port*> polled;
+    for (auto& port : ports) {
+        if (port->fd < 0) continue;
+        pollfd p = {port->fd, POLLIN, 0};
+        fds.push_back(p);
+        polled.push_back(port.get());
+    }
+    if (!fds.empty() && ::poll(fds.data(), fds.size(), timeoutMillis) > 0) {
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) continue;
+            size_t bytes = polled[i]->communicator->updateReadable();
+            if (isClosed(*polled[i]) || (bytes == 0 && (fds[i].revents & (POLLHUP | POLLERR)))) {
+                polled[i]->fd = -2;
+            }
+            serviced++;
+        }
+    }
+#endif
+
+    for (auto& port : ports) {
+        if (port->fd != -1) {
+            // Readable or not, e.g. coalesced packets waiting for room
+            port->communicator->updateTimers();
+        }
+        else {
+            port->communicator->update();
+            serviced++;
+        }
+    }
+    return serviced;
+}
+
+#endif
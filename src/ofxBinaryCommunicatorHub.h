@@ -0,0 +1,64 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <memory>
+#include <vector>
+
+// Services many communicators from one thread (openFrameworks only).
+// poll() waits on the descriptors of all their transports at once (epoll on Linux, poll() on other
+// POSIX systems) and decodes only the ports that are readable, so idle ports cost no syscalls.
+// Transports without a descriptor (ofSerial, loopback) are updated on every poll() instead;
+// open serial ports with ofxBinarySerialPortTransport to have them polled.
+// Packets fire each communicator's onReceived and subscribe() handlers as usual, and also the hub's
+// onReceived, tagged with the port they came from.
+class ofxBinaryCommunicatorHub {
+public:
+    struct ReceivedPacket {
+        int portId;                         // returned by add()
+        int deviceId;                       // given to add()
+        ofxBinaryCommunicator* communicator;
+        ofxBinaryPacket packet;
+    };
+
+    ofxBinaryCommunicatorHub();
+    ~ofxBinaryCommunicatorHub();
+
+    // Register a communicator that is already set up. It must outlive its registration and must not
+    // run its receive thread. Call add() again after setting it up with another transport.
+    // Returns the port id, or -1 on failure.
+    int add(ofxBinaryCommunicator& communicator, int deviceId = -1);
+    void remove(ofxBinaryCommunicator& communicator);
+    size_t size() const { return ports.size(); }
+
+    // Wait up to timeoutMillis for data (0: don't wait, -1: forever), then decode the readable ports
+    // and run the timers (updateTimers()) of every port. The wait is capped at 1 ms while a port
+    // without a descriptor is registered, and at 10 ms while a port has timers.
+    // A port that hangs up stops being polled. Returns the number of ports that were decoded.
+    size_t poll(int timeoutMillis = 0);
+
+    // Every port, in decode order
+    ofEvent<const ReceivedPacket> onReceived;
+
+private:
+    struct Port {
+        int id;
+        int deviceId;
+        int fd; // -1 when updated on every poll()
+        ofxBinaryCommunicator* communicator;
+        ofEventListener listener;
+    };
+
+    // Longest wait while a port has timers
+    static const int timerMillis = 10;
+
+    static bool isClosed(Port& port);
+    void unwatch(Port& port);
+
+    std::vector<std::unique_ptr<Port>> ports;
+    size_t unpolledCount;
+    int nextPortId;
+    int epollFd; // Linux only
+};
+
+#endif
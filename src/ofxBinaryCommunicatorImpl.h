@@ -0,0 +1,2220 @@
+#pragma once
+
+// Member definitions of ofxBasicBinaryCommunicator. Included at the end of ofxBinaryCommunicator.h,
+// after the reserved topics they answer.
+
+#if __cplusplus < 201703L
+// Storage for the constants (implicit from C++17)
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::MaxPacketSize;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::MaxFrameHeaderSize;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::SendBufferSize;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr uint8_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableMaxRetries;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr uint16_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableInitialRtoMillis;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr uint16_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableMinRtoMillis;
+template<size_t MaxPacket, typename Checksum, typename Transport>
+constexpr uint16_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableMaxRtoMillis;
+#endif
+
+// Constructor
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ofxBasicBinaryCommunicator() : serial(nullptr) {
+    state = ReceiveState::WaitingForHeader;
+    checksumType = ChecksumTraits::defaultType();
+    receivingChecksumType = ChecksumTraits::defaultType();
+    requestedChecksumType = ChecksumTraits::defaultType();
+    checksumRequestPending = false;
+    acceptChecksumRequests = true;
+    initialized = false;
+    sendBufferLength = 0;
+    nextTransferId = 0;
+    #if LINK_STATS
+    maxBacklog = 0;
+    skippingBytes = false;
+    #endif
+    #ifdef OF_VERSION_MAJOR
+    receiveThreaded = false;
+    receiveThreadRunning = false;
+    receiveQueuePolicy = QueueFullPolicy::DropNewest;
+    receiveQueueQueued = 0;
+    receiveQueueDropped = 0;
+    receiveQueueHighWaterMark = 0;
+    executorPort = nullptr;
+    sendThreaded = false;
+    sendThreadRunning = false;
+    sendQueuePolicy = BackpressurePolicy::Block;
+    sendPending = 0;
+    sendQueueQueued = 0;
+    sendQueueDropped = 0;
+    sendQueueHighWaterMark = 0;
+    writeFailures = 0;
+    for (int topicId = 0; topicId < 256; ++topicId) {
+        sendPriorities[topicId] = SendPriority::Normal;
+    }
+    sendWeights[(int)SendPriority::Control] = 0;
+    sendWeights[(int)SendPriority::Normal] = 4;
+    sendWeights[(int)SendPriority::Bulk] = 1;
+    coalescedTopicCount = 0;
+    coalescingWatermark = 64;
+    reliableSenderCount = 0;
+    activeStream = nullptr;
+    streamChecksumState = 0;
+    streamStagedLength = 0;
+    largeTransferTimeoutMillis = 1000;
+    maxLargeTransfers = 8;
+    nextPingSequence = 0;
+    pingsSent = 0;
+    pingIntervalMicros = 0;
+    nextPingMicros = 0;
+    readMicros = 0;
+    frameArrivalMicros = 0;
+    #else
+    subscriptionCount = 0;
+    deltaSenderCount = 0;
+    reliableSenderCount = 0;
+    reliableReceiverCount = 0;
+    #endif
+}
+
+// Destructor
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::~ofxBasicBinaryCommunicator() {
+    #ifdef OF_VERSION_MAJOR
+    stopSendThread();
+    stopReceiveThread();
+    setExecutor(nullptr);
+    transport.reset();
+    if (serial != nullptr) {
+        delete serial;
+        serial = nullptr;
+    }
+    for (int topicId = 0; topicId < 256; ++topicId) {
+        disableDelta(topicId);
+        disableReliable(topicId);
+    }
+    #else
+    while (deltaSenderCount > 0) {
+        disableDelta(deltaSenders[0].topicId);
+    }
+    while (reliableSenderCount > 0) {
+        disableReliable(reliableSenders[0].topicId);
+    }
+    #endif
+}
+
+// Setup method
+#ifdef OF_VERSION_MAJOR
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setup(const std::string& portName, int baudRate) {
+    // Don't let the threads touch the port while it is reopened
+    bool receiveThreadWasRunning = isReceiveThreadRunning();
+    bool sendThreadWasRunning = isSendThreadRunning();
+    stopSendThread();
+    stopReceiveThread();
+    
+    if (serial == nullptr) {
+        serial = new ofSerial();
+    }
+    serial->setup(portName, baudRate);
+    setup(std::make_shared<ofxBinarySerialTransport>(serial, baudRate));
+    
+    if (receiveThreadWasRunning) {
+        startReceiveThread(receiveQueue.capacity(), receiveQueuePolicy);
+    }
+    if (sendThreadWasRunning) {
+        startSendThread(sendQueues[(int)SendPriority::Normal].capacity(), sendQueuePolicy);
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setup(std::shared_ptr<Transport> newTransport) {
+    bool receiveThreadWasRunning = isReceiveThreadRunning();
+    bool sendThreadWasRunning = isSendThreadRunning();
+    stopSendThread();
+    stopReceiveThread();
+    
+    transport = newTransport;
+    initialized = transport && transport->isOpen();
+    
+    if (receiveThreadWasRunning) {
+        startReceiveThread(receiveQueue.capacity(), receiveQueuePolicy);
+    }
+    if (sendThreadWasRunning) {
+        startSendThread(sendQueues[(int)SendPriority::Normal].capacity(), sendQueuePolicy);
+    }
+}
+#else
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setup(Transport& serialStream) {
+    serial = &serialStream;
+    initialized = true;
+}
+#endif
+
+// Update method to process incoming data
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::update() {
+    #ifdef OF_VERSION_MAJOR
+    if (isReceiveThreadRunning()) {
+        drainReceiveQueue();
+    }
+    else {
+        while (readTransport() > 0);
+    }
+    #else
+    #if LINK_STATS
+    int available = serial->available();
+    if (available > maxBacklog) maxBacklog = available;
+    #endif
+    while (serial->available() > 0) {
+        uint8_t incomingByte = serial->read();
+        #if LINK_STATS
+        rxBytes.add(1);
+        #endif
+        processIncomingByte(incomingByte);
+    }
+    #endif
+    updateTimers();
+}
+
+#ifdef OF_VERSION_MAJOR
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::updateReadable() {
+    if (isReceiveThreadRunning() || !transport) return 0;
+    
+    size_t total = 0;
+    for (;;) {
+        long n = transport->readSome(readBuffer, READ_BUFFER_SIZE);
+        if (n <= 0) break;
+        readMicros = ofGetElapsedTimeMicros();
+        processIncomingBytes(readBuffer, n);
+        total += n;
+        // A short read means the OS buffer is empty
+        if (n < READ_BUFFER_SIZE) break;
+    }
+    return total;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::hasTimers() const {
+    return writeFailures > 0 || !largeTransfers.empty() || coalescedTopicCount > 0 || reliableSenderCount > 0 || pingIntervalMicros > 0;
+}
+#endif
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::updateTimers() {
+#ifdef OF_VERSION_MAJOR
+    reportWriteFailures();
+    if (!largeTransfers.empty()) {
+        expireLargeTransfers();
+    }
+    if (coalescedTopicCount > 0) {
+        flushCoalesced();
+    }
+    if (pingIntervalMicros > 0) {
+        uint64_t now = ofGetElapsedTimeMicros();
+        if (now >= nextPingMicros) {
+            nextPingMicros = now + pingIntervalMicros;
+            sendPing();
+        }
+    }
+#endif
+    if (reliableSenderCount > 0) {
+        updateReliable();
+    }
+}
+
+#ifdef OF_VERSION_MAJOR
+// Read one chunk from the OS buffer and decode it in bulk.
+// Returns the number of bytes read.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::readTransport() {
+    if (!transport) return 0;
+    
+    int available = transport->available();
+    if (available <= 0) return 0;
+    #if LINK_STATS
+    if (available > maxBacklog) maxBacklog = available;
+    #endif
+    
+    size_t size = available < READ_BUFFER_SIZE ? available : READ_BUFFER_SIZE;
+    long n = transport->readSome(readBuffer, size);
+    if (n <= 0) return 0;
+    readMicros = ofGetElapsedTimeMicros();
+    processIncomingBytes(readBuffer, n);
+    return n;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::startReceiveThread(size_t queueDepth, QueueFullPolicy policy) {
+    stopReceiveThread();
+    
+    receiveQueue.allocate(queueDepth);
+    receiveQueuePolicy = policy;
+    receiveQueueQueued = 0;
+    receiveQueueDropped = 0;
+    receiveQueueHighWaterMark = 0;
+    
+    receiveThreaded = true;
+    receiveThreadRunning = true;
+    receiveThread = std::thread(&ofxBasicBinaryCommunicator::receiveThreadFunction, this);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::stopReceiveThread() {
+    if (!receiveThread.joinable()) return;
+    
+    receiveThreadRunning = false;
+    receiveThread.join();
+    receiveThreaded = false;
+    
+    // Deliver what was already decoded
+    drainReceiveQueue();
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::ReceiveQueueStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getReceiveQueueStats() const {
+    ReceiveQueueStats stats;
+    stats.queued = receiveQueueQueued;
+    stats.dropped = receiveQueueDropped;
+    stats.depth = receiveQueue.size();
+    stats.highWaterMark = receiveQueueHighWaterMark;
+    return stats;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receiveThreadFunction() {
+    while (receiveThreadRunning) {
+        if (readTransport() > 0) continue;
+        
+        // Block until the port is readable (ofSerial has no handle, so that one sleeps 1 ms).
+        // A closed transport returns at once and nothing more will arrive, so don't spin on it.
+        if (transport && transport->isOpen()) {
+            transport->waitReadable(10);
+        }
+        else {
+            ofSleepMillis(transport ? 10 : 1);
+        }
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::startSendThread(size_t queueDepth, BackpressurePolicy policy) {
+    stopSendThread();
+    flushSendBuffer();
+    
+    // Normal always gets a queue, the other classes only if a topic uses them
+    bool used[3] = {false, true, false};
+    for (int topicId = 0; topicId < 256; ++topicId) {
+        used[(int)sendPriorities[topicId]] = true;
+    }
+    for (int priority = 0; priority < 3; ++priority) {
+        if (used[priority]) sendQueues[priority].allocate(queueDepth);
+        sendDeficits[priority] = 0;
+    }
+    sendTurn = SendPriority::Normal;
+    sendDeficits[(int)SendPriority::Normal] = (int64_t)sendWeights[(int)SendPriority::Normal] * MaxPacket;
+    sendQueuePolicy = policy;
+    sendPending = 0;
+    sendQueueQueued = 0;
+    sendQueueDropped = 0;
+    sendQueueHighWaterMark = 0;
+    
+    sendThreaded = true;
+    sendThreadRunning = true;
+    sendThread = std::thread(&ofxBasicBinaryCommunicator::sendThreadFunction, this);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::stopSendThread() {
+    if (!sendThread.joinable()) return;
+    
+    sendThreadRunning = false;
+    sendCondition.notify_one();
+    sendThread.join();
+    sendThreaded = false;
+    
+    // Write frames pushed while the thread was stopping
+    while (writeNextFrame()) {
+        sendPending--;
+    }
+    flushSendBuffer();
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::SendResult ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendPacketAsync(const ofxBinaryPacket& packet) {
+    if (coalesce(packet)) return SendResult::Ok;
+    SendPriority priority = sendPriorities[packet.topicId];
+    return sendEncoded(packet, [this, priority](const ofxBinaryPacket& frame) { return queueFrame(frame, priority); });
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::SendResult ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::queueFrame(const ofxBinaryPacket& packet, SendPriority priority) {
+    if (!sendThreaded) {
+        bufferFrame(packet);
+        flushSendBuffer();
+        return SendResult::Ok;
+    }
+    if (packet.length > MaxPacket) {
+        return SendResult::TooLarge;
+    }
+    
+    ofxBinaryMpmcQueue<SendSlot>& sendQueue = sendQueues[(int)priority].capacity() > 0 ? sendQueues[(int)priority] : sendQueues[(int)SendPriority::Normal];
+    
+    // Count it before pushing so flush() never sees 0 while the frame is in flight
+    sendPending++;
+    ofxBinaryChecksumType type = checksumType;
+    auto encode = [&packet, type](SendSlot& slot) {
+        slot.length = encodeFrame(packet, slot.frame, type);
+        slot.topicId = packet.topicId;
+        slot.payloadLength = packet.length;
+        slot.escapes = slot.length - getFrameHeaderSize(type) - packet.length;
+    };
+    while (!sendQueue.push(encode)) {
+        switch (sendQueuePolicy) {
+            case BackpressurePolicy::Block:
+                sendCondition.notify_one();
+                std::this_thread::yield();
+                break;
+            case BackpressurePolicy::DropOldest:
+                if (sendQueue.pop([](SendSlot&) {})) {
+                    sendPending--;
+                    sendQueueDropped++;
+                }
+                break;
+            case BackpressurePolicy::DropNewest:
+                sendPending--;
+                sendQueueDropped++;
+                return SendResult::Dropped;
+            case BackpressurePolicy::ReturnError:
+                sendPending--;
+                return SendResult::QueueFull;
+        }
+    }
+    
+    sendQueueQueued++;
+    size_t depth = getSendQueueDepth();
+    size_t highWaterMark = sendQueueHighWaterMark;
+    while (depth > highWaterMark && !sendQueueHighWaterMark.compare_exchange_weak(highWaterMark, depth));
+    
+    sendCondition.notify_one();
+    return SendResult::Ok;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::flush(float timeoutSec) {
+    float startTime = ofGetElapsedTimef();
+    while (sendPending > 0) {
+        if (ofGetElapsedTimef() - startTime >= timeoutSec) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::SendQueueStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getSendQueueStats() const {
+    SendQueueStats stats;
+    stats.queued = sendQueueQueued;
+    stats.dropped = sendQueueDropped;
+    stats.depth = getSendQueueDepth();
+    stats.highWaterMark = sendQueueHighWaterMark;
+    return stats;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setSendWeights(uint32_t normalWeight, uint32_t bulkWeight) {
+    // A class with no weight would never get a turn
+    sendWeights[(int)SendPriority::Normal] = normalWeight > 0 ? normalWeight : 1;
+    sendWeights[(int)SendPriority::Bulk] = bulkWeight > 0 ? bulkWeight : 1;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getSendQueueDepth() const {
+    return sendQueues[0].size() + sendQueues[1].size() + sendQueues[2].size();
+}
+
+// Move the next frame into the send buffer: Control first, then Normal and Bulk by deficit round robin.
+// Each turn adds weight * MaxPacket bytes to a class's deficit, and it writes while the deficit lasts.
+// Returns false if every queue is empty. Writer thread only.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::writeNextFrame() {
+    size_t length = 0;
+    auto write = [this, &length](SendSlot& slot) {
+        bufferEncodedFrame(slot.frame, slot.length);
+#if LINK_STATS
+        countSentFrame(slot.topicId, slot.payloadLength, slot.escapes);
+#endif
+        length = slot.length;
+    };
+    ofxBinaryMpmcQueue<SendSlot>& control = sendQueues[(int)SendPriority::Control];
+    if (control.capacity() > 0 && control.pop(write)) return true;
+    
+    for (int i = 0; i < 3; ++i) {
+        int turn = (int)sendTurn;
+        if (sendDeficits[turn] > 0) {
+            if (sendQueues[turn].capacity() > 0 && sendQueues[turn].pop(write)) {
+                sendDeficits[turn] -= length;
+                return true;
+            }
+            // An idle class doesn't save up
+            sendDeficits[turn] = 0;
+        }
+        sendTurn = sendTurn == SendPriority::Normal ? SendPriority::Bulk : SendPriority::Normal;
+        sendDeficits[(int)sendTurn] += (int64_t)sendWeights[(int)sendTurn] * MaxPacket;
+    }
+    return false;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendThreadFunction() {
+    // Frames buffered between writes. Small enough that flush() and the coalescing see progress.
+    const int64_t batchSize = 32;
+    for (;;) {
+        // Coalesce whatever is queued into as few writes as possible
+        int64_t written = 0;
+        while (written < batchSize && writeNextFrame()) {
+            written++;
+        }
+        if (written > 0) {
+            flushSendBuffer();
+            sendPending -= written;
+            continue;
+        }
+        
+        if (!sendThreadRunning) break;
+        
+        std::unique_lock<std::mutex> lock(sendMutex);
+        sendCondition.wait_for(lock, std::chrono::milliseconds(1), [this] {
+            return getSendQueueDepth() > 0 || !sendThreadRunning;
+        });
+    }
+}
+
+// Append an already encoded frame to the send buffer (writer thread)
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::bufferEncodedFrame(const uint8_t* frame, size_t length) {
+    if (sendBufferLength + length > SendBufferSize) {
+        flushSendBuffer();
+    }
+    if (length > SendBufferSize) {
+        writeTransport(frame, length);
+        return;
+    }
+    memcpy(sendBuffer + sendBufferLength, frame, length);
+    sendBufferLength += length;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setCoalescing(uint8_t topicId, float maxRateHz) {
+    // 241 and above are reserved
+    if (topicId > 240) return false;
+    
+    std::lock_guard<std::mutex> lock(coalesceMutex);
+    CoalescedTopic* topic = coalescedTopics[topicId].get();
+    if (topic == nullptr) {
+        topic = new CoalescedTopic();
+        topic->nextSendMicros = 0;
+        topic->stats = CoalesceStats();
+        topic->length = 0;
+        coalescedTopics[topicId].reset(topic);
+        coalescedTopicCount++;
+    }
+    topic->intervalMicros = maxRateHz > 0 ? (uint64_t)(1000000 / maxRateHz) : 0;
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::clearCoalescing(uint8_t topicId) {
+    std::lock_guard<std::mutex> lock(coalesceMutex);
+    CoalescedTopic* topic = coalescedTopics[topicId].get();
+    if (topic == nullptr) return;
+    if (topic->stats.pending) {
+        SendPriority priority = sendPriorities[topicId];
+        sendEncoded(ofxBinaryPacket(topicId, topic->length, topic->data), [this, priority](const ofxBinaryPacket& frame) { return queueFrame(frame, priority); });
+    }
+    coalescedTopics[topicId].reset();
+    coalescedTopicCount--;
+}
+
+// Write the packet of a coalesced topic if the link has room, otherwise keep it as the pending one.
+// Returns false if the topic isn't coalesced.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::coalesce(const ofxBinaryPacket& packet) {
+    // Don't take the lock while no topic is coalesced. The table itself is only read under the lock,
+    // setCoalescing() and clearCoalescing() may change it from another thread.
+    if (coalescedTopicCount == 0) return false;
+    std::lock_guard<std::mutex> lock(coalesceMutex);
+    CoalescedTopic* topic = coalescedTopics[packet.topicId].get();
+    if (topic == nullptr || packet.length > MaxPacket) return false;
+    
+    topic->stats.submitted++;
+    if (topic->stats.pending) {
+        topic->stats.superseded++;
+    }
+    uint64_t now = ofGetElapsedTimeMicros();
+    if (now >= topic->nextSendMicros && hasSendRoom()) {
+        topic->stats.pending = false;
+        topic->stats.sent++;
+        topic->nextSendMicros = now + topic->intervalMicros;
+        SendPriority priority = sendPriorities[packet.topicId];
+        sendEncoded(packet, [this, priority](const ofxBinaryPacket& frame) { return queueFrame(frame, priority); });
+        return true;
+    }
+    memcpy(topic->data, packet.data, packet.length);
+    topic->length = packet.length;
+    topic->stats.pending = true;
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::flushCoalesced() {
+    std::lock_guard<std::mutex> lock(coalesceMutex);
+    // Checked once per pass, so each due topic gets a turn even if the first one fills the link
+    if (!hasSendRoom()) return 0;
+    
+    uint64_t now = ofGetElapsedTimeMicros();
+    size_t count = 0;
+    for (int topicId = 0; topicId < 256; ++topicId) {
+        CoalescedTopic* topic = coalescedTopics[topicId].get();
+        if (topic == nullptr || !topic->stats.pending || now < topic->nextSendMicros) continue;
+        topic->stats.pending = false;
+        topic->stats.sent++;
+        topic->nextSendMicros = now + topic->intervalMicros;
+        SendPriority priority = sendPriorities[topicId];
+        sendEncoded(ofxBinaryPacket(topicId, topic->length, topic->data), [this, priority](const ofxBinaryPacket& frame) { return queueFrame(frame, priority); });
+        count++;
+    }
+    return count;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::CoalesceStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getCoalesceStats(uint8_t topicId) const {
+    std::lock_guard<std::mutex> lock(coalesceMutex);
+    if (!coalescedTopics[topicId]) return CoalesceStats();
+    return coalescedTopics[topicId]->stats;
+}
+
+// Whether the link keeps up: nothing waits for the writer thread and the transport holds at most the watermark
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::hasSendRoom() {
+    if (sendThreaded && sendPending > 0) return false;
+    if (!transport) return true;
+    int pending = transport->pendingWrite();
+    return pending < 0 || (size_t)pending <= coalescingWatermark;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::drainReceiveQueue() {
+    ReceivedSlot* slot;
+    while ((slot = receiveQueue.front()) != nullptr) {
+        if (slot->isError) {
+            dispatchError(slot->error);
+        }
+        else {
+            ofxBinaryPacket packet(slot->topicId, slot->length, slot->data);
+            packet.arrivalMicros = slot->arrivalMicros;
+            dispatchReceived(packet);
+        }
+        receiveQueue.pop();
+    }
+}
+#endif
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendPacket(const ofxBinaryPacket& packet) {
+#ifdef OF_VERSION_MAJOR
+    if (sendThreaded) {
+        sendPacketAsync(packet);
+        return;
+    }
+    if (coalesce(packet)) return;
+#endif
+    sendEncoded(packet, [this](const ofxBinaryPacket& frame) {
+        bufferFrame(frame);
+        flushSendBuffer();
+    });
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendLarge(uint8_t topicId, const uint8_t* data, size_t length) {
+    if (length <= MaxPacket) {
+        sendPacket(ofxBinaryPacket(topicId, length, data));
+        return true;
+    }
+    if (length > 0xFFFF) return false;
+    // A tiny link can't carry any payload next to the header
+    if (MaxPacket <= sizeof(FragmentHeader)) return false;
+    
+    FragmentHeader header;
+    header.transferId = nextTransferId++;
+    header.payloadTopicId = topicId;
+    header.totalLength = length;
+    
+    const size_t chunkSize = MaxPacket - sizeof(FragmentHeader);
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(framePayloadMutex);
+#endif
+    for (size_t offset = 0; offset < length; offset += chunkSize) {
+        size_t chunkLength = length - offset < chunkSize ? length - offset : chunkSize;
+        header.offset = offset;
+        memcpy(framePayload, &header, sizeof(header));
+        memcpy(framePayload + sizeof(header), data + offset, chunkLength);
+        // Reserved topic: never coalesced, reliable or delta, so sendPacket() doesn't take framePayload again
+        ofxBinaryPacket fragment(FragmentHeader::topicId, sizeof(header) + chunkLength, framePayload);
+#ifdef OF_VERSION_MAJOR
+        if (sendThreaded) {
+            // Queued one by one under the payload topic's priority, so other frames can go in between
+            queueFrame(fragment, sendPriorities[topicId]);
+            continue;
+        }
+#endif
+        sendPacket(fragment);
+    }
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendCompact(const OscLikeMessage& message) {
+    uint8_t buffer[OscLikeMessage::MAX_ENCODED_SIZE];
+    sendPacket(message.toCompactPacket(buffer));
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendPackets(const ofxBinaryPacket* packets, size_t count) {
+#ifdef OF_VERSION_MAJOR
+    if (sendThreaded) {
+        for (size_t i = 0; i < count; ++i) {
+            sendPacketAsync(packets[i]);
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+#ifdef OF_VERSION_MAJOR
+        if (coalesce(packets[i])) continue;
+#endif
+        sendEncoded(packets[i], [this](const ofxBinaryPacket& frame) { bufferFrame(frame); });
+    }
+    flushSendBuffer();
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::encodeFrame(const ofxBinaryPacket& packet, uint8_t* out, ofxBinaryChecksumType checksumType) {
+    size_t size = encodeFrameHeader(packet, out, checksumType);
+    size += escapePayload(packet.data, packet.length, out + size);
+    return size;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::encodeFrameHeader(const ofxBinaryPacket& packet, uint8_t* out, ofxBinaryChecksumType checksumType) {
+    uint32_t checksum = calculateChecksum(packet.data, packet.length, checksumType);
+    uint8_t checksumSize = ChecksumTraits::getSize(checksumType);
+    size_t size = 0;
+    out[size++] = HeaderByte;
+    // 2 or 4 bytes, big endian
+    for (int shift = (checksumSize - 1) * 8; shift >= 0; shift -= 8) {
+        out[size++] = (checksum >> shift) & 0xFF;
+    }
+    out[size++] = packet.topicId;
+    // 2 bytes
+    out[size++] = packet.length >> 8;
+    out[size++] = packet.length & 0xFF;
+    return size;
+}
+
+// Append a frame to the send buffer, flushing as needed
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::bufferFrame(const ofxBinaryPacket& packet) {
+    size_t maxFrameSize = getMaxFrameSize(packet.length);
+    if (sendBufferLength + maxFrameSize > SendBufferSize) {
+        flushSendBuffer();
+    }
+    
+    if (maxFrameSize <= SendBufferSize) {
+        size_t frameLength = encodeFrame(packet, sendBuffer + sendBufferLength, checksumType);
+        sendBufferLength += frameLength;
+#if LINK_STATS
+        countSentFrame(packet.topicId, packet.length, frameLength - getFrameHeaderSize(checksumType) - packet.length);
+#endif
+        return;
+    }
+    
+    // The frame is larger than the buffer, so escape the payload piece by piece
+    sendBufferLength += encodeFrameHeader(packet, sendBuffer + sendBufferLength, checksumType);
+    size_t escapedLength = 0;
+    size_t offset = 0;
+    while (offset < packet.length) {
+        size_t n = (SendBufferSize - sendBufferLength) / 2;
+        if (n == 0) {
+            flushSendBuffer();
+            continue;
+        }
+        if (n > packet.length - offset) n = packet.length - offset;
+        size_t escaped = escapePayload(packet.data + offset, n, sendBuffer + sendBufferLength);
+        sendBufferLength += escaped;
+        escapedLength += escaped;
+        offset += n;
+    }
+#if LINK_STATS
+    countSentFrame(packet.topicId, packet.length, escapedLength - packet.length);
+#else
+    (void)escapedLength;
+#endif
+}
+
+#if LINK_STATS
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::countSentFrame(uint8_t topicId, uint16_t payloadLength, size_t escapes) {
+    txFrames.add(1);
+    txPayloadBytes.add(payloadLength);
+    txEscapes.add(escapes);
+#ifdef OF_VERSION_MAJOR
+    topicCounters[topicId].txPackets.add(1);
+    topicCounters[topicId].txBytes.add(payloadLength);
+#else
+    (void)topicId;
+#endif
+}
+#endif
+
+// Write the send buffer to the serial with one call
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::flushSendBuffer() {
+    if (sendBufferLength == 0) return;
+    writeTransport(sendBuffer, sendBufferLength);
+    sendBufferLength = 0;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::writeTransport(const uint8_t* data, size_t length) {
+    #ifdef OF_VERSION_MAJOR
+    if (transport) {
+        size_t written = 0;
+        while (written < length) {
+            long n = transport->writeSome(data + written, length - written);
+            if (n <= 0) break;
+            written += n;
+        }
+        #if LINK_STATS
+        txBytes.add(written);
+        #endif
+        // May run on the writer thread, so update() reports it
+        if (written < length) writeFailures++;
+    }
+    #else
+    size_t written = serial->write(data, length);
+    #if LINK_STATS
+    txBytes.add(written);
+    #endif
+    if (written < length) notifyError(ErrorType::WriteFailed);
+    #endif
+}
+
+// Append unescaped payload to the packet being received
+template<size_t MaxPacket, typename Checksum, typename Transport>
+inline void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::storeReceivedByte(uint8_t byte) {
+#ifdef OF_VERSION_MAJOR
+    if (activeStream != nullptr) {
+        stageStreamByte(byte);
+        receivedLength++;
+        return;
+    }
+#endif
+    receivedData[receivedLength++] = byte;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+inline void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::storeReceivedRun(const uint8_t* data, size_t length) {
+#ifdef OF_VERSION_MAJOR
+    if (activeStream != nullptr) {
+        // Hand the run over straight from the read buffer
+        flushStreamChunk();
+        deliverStreamChunk(data, length);
+        receivedLength += length;
+        return;
+    }
+#endif
+    memcpy(receivedData + receivedLength, data, length);
+    receivedLength += length;
+}
+
+// Process a chunk of incoming bytes.
+// Same result as calling processIncomingByte() for each byte, but clean payload runs
+// are copied with memcpy and garbage before a header is skipped with memchr.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::processIncomingBytes(const uint8_t* data, size_t length) {
+#if LINK_STATS
+    rxBytes.add(length);
+#endif
+    while (length > 0) {
+        if (state == ReceiveState::WaitingForHeader) {
+            const uint8_t* header = (const uint8_t*)memchr(data, HeaderByte, length);
+#if LINK_STATS
+            size_t skipped = header != nullptr ? header - data : length;
+            if (skipped > 0) {
+                if (!skippingBytes) resyncs.add(1);
+                skippingBytes = true;
+                skippedBytes.add(skipped);
+            }
+#endif
+            if (header == nullptr) return;
+            length -= header - data;
+            data = header;
+        }
+        else if (state == ReceiveState::ReceivingData) {
+            size_t remaining = packetLength - receivedLength;
+            size_t n = remaining < length ? remaining : length;
+            size_t run = findSpecialByte(data, n);
+            storeReceivedRun(data, run);
+            data += run;
+            length -= run;
+            
+            if (receivedLength == packetLength) {
+                packetReceived();
+                state = ReceiveState::WaitingForHeader;
+                continue;
+            }
+            // Leave the escape or header byte to the state machine
+            if (length == 0) break;
+        }
+        
+        processIncomingByte(*data++);
+        length--;
+    }
+#ifdef OF_VERSION_MAJOR
+    // Don't hold staged bytes until the next read
+    if (activeStream != nullptr) {
+        flushStreamChunk();
+    }
+#endif
+}
+
+// Process each incoming byte
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::processIncomingByte(uint8_t byte) {
+    switch (state) {
+        case ReceiveState::WaitingForHeader:
+            if (byte == HeaderByte) {
+                state = ReceiveState::ReceivingChecksum;
+                receivingChecksumType = checksumType;
+                receivedChecksum = 0;
+                receivedLength = 0;
+#ifdef OF_VERSION_MAJOR
+                frameArrivalMicros = readMicros;
+#endif
+#if LINK_STATS
+                skippingBytes = false;
+#endif
+            } else {
+                // 無視してゴミbyteを捨てる
+#if LINK_STATS
+                if (!skippingBytes) resyncs.add(1);
+                skippingBytes = true;
+                skippedBytes.add(1);
+#endif
+            }
+            break;
+
+        case ReceiveState::ReceivingChecksum:
+            receivedChecksum = (receivedChecksum << 8) | byte;
+            if (receivedLength + 1 == ChecksumTraits::getSize(receivingChecksumType)) {
+                state = ReceiveState::ReceivingTopicId;
+                topicId = 0;
+                receivedLength = 0;
+            } else {
+                receivedLength++;
+            }
+            break;
+
+        case ReceiveState::ReceivingTopicId:
+            topicId = byte;
+            state = ReceiveState::ReceivingLength;
+            packetLength = 0;
+            receivedLength = 0;
+            break;
+
+        case ReceiveState::ReceivingLength:
+            packetLength = (packetLength << 8) | byte;
+            if (receivedLength == 1) {
+                state = ReceiveState::ReceivingData;
+                receivedLength = 0;
+#ifdef OF_VERSION_MAJOR
+                if (streamHandlers[topicId]) {
+                    beginStream();
+                    if (packetLength == 0) {
+                        packetReceived();
+                        state = ReceiveState::WaitingForHeader;
+                    }
+                    break;
+                }
+#endif
+                if (packetLength > MaxPacket) {
+                    notifyError(ErrorType::BufferOverflow);
+                    state = ReceiveState::WaitingForHeader;
+                }
+                else if (packetLength == 0) {
+                    // No payload follows
+                    packetReceived();
+                    state = ReceiveState::WaitingForHeader;
+                }
+            } else {
+                receivedLength++;
+            }
+            break;
+
+        case ReceiveState::ReceivingData:
+            if (byte == EscapeByte) {
+                state = ReceiveState::ReceivingEscape;
+#if LINK_STATS
+                rxEscapes.add(1);
+#endif
+            } else if (byte == HeaderByte) {
+                // 未エスケープのHeaderByteを受信した場合
+                // 今読んでいたパケットは不完全で捨てる(エラーとして扱うなら notifyError も呼ぶ)
+#ifdef OF_VERSION_MAJOR
+                if (activeStream != nullptr) abortStream(ErrorType::UnexpectedHeader);
+#endif
+                notifyError(ErrorType::UnexpectedHeader);
+
+                // 新しいパケットの先頭(ヘッダ)が来たとみなして、最初から受信やり直し
+                state = ReceiveState::ReceivingChecksum;
+                receivingChecksumType = checksumType;
+                receivedChecksum = 0;
+                receivedLength   = 0;
+#ifdef OF_VERSION_MAJOR
+                frameArrivalMicros = readMicros;
+#endif
+            } else {
+                storeReceivedByte(byte);
+                if (receivedLength == packetLength) {
+                    packetReceived();
+                    state = ReceiveState::WaitingForHeader;
+                } else if (receivedLength > packetLength) {
+                    notifyError(ErrorType::BufferOverflow);
+                    state = ReceiveState::WaitingForHeader;
+                }
+            }
+            break;
+
+        case ReceiveState::ReceivingEscape:
+            if (byte == HeaderByte || byte == EscapeByte) {
+                storeReceivedByte(byte);
+                if (receivedLength == packetLength) {
+                    packetReceived();
+                    state = ReceiveState::WaitingForHeader;
+                } else if (receivedLength > packetLength) {
+                    notifyError(ErrorType::BufferOverflow);
+                    state = ReceiveState::WaitingForHeader;
+                } else {
+                    state = ReceiveState::ReceivingData;
+                }
+            } else {
+                // 不正なエスケープシーケンス
+#ifdef OF_VERSION_MAJOR
+                if (activeStream != nullptr) abortStream(ErrorType::UnknownError);
+#endif
+                notifyError(ErrorType::UnknownError);
+                state = ReceiveState::WaitingForHeader;
+            }
+            break;
+    }
+}
+
+// Handle a fully received packet
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::packetReceived() {
+#ifdef OF_VERSION_MAJOR
+    if (activeStream != nullptr) {
+        if (!finishStream()) return false;
+    #if LINK_STATS
+        rxFrames.add(1);
+        rxPayloadBytes.add(packetLength);
+        topicCounters[topicId].rxPackets.add(1);
+        topicCounters[topicId].rxBytes.add(packetLength);
+    #endif
+        return true;
+    }
+#endif
+    uint32_t calculatedChecksum = calculateChecksum(receivedData, packetLength, receivingChecksumType);
+    if (calculatedChecksum == receivedChecksum) {
+#if LINK_STATS
+        rxFrames.add(1);
+        rxPayloadBytes.add(receivedLength);
+    #ifdef OF_VERSION_MAJOR
+        topicCounters[topicId].rxPackets.add(1);
+        topicCounters[topicId].rxBytes.add(receivedLength);
+    #endif
+#endif
+        ofxBinaryPacket packet(topicId, receivedLength, receivedData);
+#ifdef OF_VERSION_MAJOR
+        packet.arrivalMicros = frameArrivalMicros;
+#endif
+        notifyReceived(packet);
+        return true;
+    } else {
+        notifyError(ErrorType::ChecksumMismatch);
+        return false;
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+uint32_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::calculateChecksum(const uint8_t* data, uint16_t length, ofxBinaryChecksumType checksumType) {
+    return ChecksumTraits::calculate(checksumType, data, length);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::requestChecksumType(ofxBinaryChecksumType type) {
+    requestedChecksumType = type;
+    checksumRequestPending = true;
+    
+    ChecksumRequest req;
+    req.checksumType = (uint8_t)type;
+    send(req);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::handleReservedPacket(const ofxBinaryPacket& packet) {
+    switch (packet.topicId) {
+        case ChecksumRequest::topicId: {
+            ChecksumRequest req;
+            if (!packet.unpack(req)) return false;
+            
+            // Answer with the current checksum, then switch
+            ChecksumResponse res;
+            res.checksumType = req.checksumType;
+            res.accepted = acceptChecksumRequests && ChecksumTraits::isSupported(req.checksumType);
+            // Queued frames keep the checksum they were encoded with
+            send(res);
+            if (res.accepted) {
+                checksumType = (ofxBinaryChecksumType)req.checksumType;
+            }
+            return true;
+        }
+        case ChecksumResponse::topicId: {
+            ChecksumResponse res;
+            if (!packet.unpack(res)) return false;
+            
+            if (checksumRequestPending && res.checksumType == (uint8_t)requestedChecksumType) {
+                checksumRequestPending = false;
+                if (res.accepted) {
+                    checksumType = requestedChecksumType;
+                }
+            }
+            return true;
+        }
+        case FragmentHeader::topicId:
+#ifdef OF_VERSION_MAJOR
+            receiveFragment(packet);
+#endif
+            // Reassembly is openFrameworks only, Arduino drops fragments
+            return true;
+        case DeltaHeader::topicId:
+#ifdef OF_VERSION_MAJOR
+            receiveDelta(packet);
+#endif
+            // Decoding is openFrameworks only, Arduino drops delta frames
+            return true;
+        case DeltaKeyframeRequest::topicId: {
+            DeltaKeyframeRequest req;
+            if (!packet.unpack(req)) return false;
+            
+#ifdef OF_VERSION_MAJOR
+            std::lock_guard<std::mutex> lock(deltaMutex);
+#endif
+            DeltaSender* delta = findDeltaSender(req.payloadTopicId);
+            if (delta != nullptr) {
+                delta->keyframeRequested = true;
+            }
+            return true;
+        }
+        case ReliableHeader::topicId:
+            receiveReliable(packet);
+            return true;
+        case ReliableAck::topicId:
+            receiveReliableAck(packet);
+            return true;
+        case Ping::topicId: {
+            Ping ping;
+            if (!packet.unpack(ping)) return false;
+            
+            Pong pong;
+            pong.sequence = ping.sequence;
+            pong.timestamp = ping.timestamp;
+#ifdef OF_VERSION_MAJOR
+            pong.answerMicros = (uint32_t)ofGetElapsedTimeMicros();
+            pong.answerMillis = (uint32_t)ofGetElapsedTimeMillis();
+#else
+            pong.answerMicros = micros();
+            pong.answerMillis = millis();
+#endif
+            send(pong);
+            return true;
+        }
+        case Pong::topicId:
+            // openFrameworks records it before the packet gets here; Arduino doesn't measure
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::isInternalTopic(uint8_t topicId) {
+    return topicId == ChecksumRequest::topicId || topicId == ChecksumResponse::topicId || topicId == FragmentHeader::topicId
+        || topicId == DeltaHeader::topicId || topicId == DeltaKeyframeRequest::topicId
+        || topicId == ReliableHeader::topicId || topicId == ReliableAck::topicId
+        || topicId == Ping::topicId || topicId == Pong::topicId;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::enableDelta(uint8_t topicId, uint16_t maxLength, uint16_t keyframeInterval) {
+    // 241 and above are reserved
+    if (topicId > 240 || sizeof(DeltaHeader) + (size_t)maxLength > MaxPacket) return false;
+    disableDelta(topicId);
+    
+    DeltaSender* delta;
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(deltaMutex);
+    deltaSenders[topicId].reset(new DeltaSender());
+    delta = deltaSenders[topicId].get();
+#else
+    if (deltaSenderCount >= MAX_DELTA_TOPICS) return false;
+    delta = &deltaSenders[deltaSenderCount++];
+#endif
+    delta->topicId = topicId;
+    delta->valid = false;
+    delta->keyframeRequested = false;
+    delta->sequence = 0;
+    delta->keyframeInterval = keyframeInterval;
+    delta->sinceKeyframe = 0;
+    delta->length = 0;
+    delta->capacity = maxLength;
+    delta->last = new uint8_t[maxLength > 0 ? maxLength : 1];
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::disableDelta(uint8_t topicId) {
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(deltaMutex);
+    if (deltaSenders[topicId]) {
+        delete[] deltaSenders[topicId]->last;
+        deltaSenders[topicId].reset();
+    }
+#else
+    for (uint8_t i = 0; i < deltaSenderCount; ++i) {
+        if (deltaSenders[i].topicId == topicId) {
+            delete[] deltaSenders[i].last;
+            deltaSenders[i] = deltaSenders[--deltaSenderCount];
+            return;
+        }
+    }
+#endif
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+typename ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::DeltaSender* ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::findDeltaSender(uint8_t topicId) {
+#ifdef OF_VERSION_MAJOR
+    return deltaSenders[topicId].get();
+#else
+    for (uint8_t i = 0; i < deltaSenderCount; ++i) {
+        if (deltaSenders[i].topicId == topicId) return &deltaSenders[i];
+    }
+    return nullptr;
+#endif
+}
+
+// Call send with the packet as it goes on the wire: a ReliableHeader frame if the topic is reliable,
+// a DeltaHeader frame if it is delta encoded
+template<size_t MaxPacket, typename Checksum, typename Transport>
+template<typename Send>
+auto ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendEncoded(const ofxBinaryPacket& packet, Send send) -> decltype(send(packet)) {
+#ifdef OF_VERSION_MAJOR
+    // Don't take the locks for topics that were never enabled
+    if (!reliableSenders[packet.topicId] && !deltaSenders[packet.topicId]) return send(packet);
+#endif
+    {
+#ifdef OF_VERSION_MAJOR
+        std::unique_lock<std::mutex> lock(reliableMutex);
+#endif
+        ReliableSender* reliable = findReliableSender(packet.topicId);
+        if (reliable != nullptr) {
+            if (packet.length > reliable->capacity || (uint16_t)(reliable->next - reliable->base) >= reliable->window) {
+                reliable->stats.rejected++;
+                return sendRejected((decltype(send(packet))*)nullptr);
+            }
+            uint16_t sequence = reliable->next++;
+            uint8_t index = sequence % reliable->window;
+            ReliableSlot& slot = reliable->slots[index];
+            slot.sequence = sequence;
+            slot.length = packet.length;
+            slot.sentMillis = getMillis();
+            slot.retries = 0;
+            slot.pending = true;
+            memcpy(reliable->data + (size_t)index * reliable->capacity, packet.data, packet.length);
+            reliable->stats.sent++;
+#ifdef OF_VERSION_MAJOR
+            std::lock_guard<std::mutex> payloadLock(framePayloadMutex);
+#endif
+            return send(encodeReliable(*reliable, sequence, framePayload));
+        }
+    }
+    
+#ifdef OF_VERSION_MAJOR
+    if (!deltaSenders[packet.topicId]) return send(packet);
+    std::unique_lock<std::mutex> lock(deltaMutex);
+#endif
+    DeltaSender* delta = findDeltaSender(packet.topicId);
+    if (delta == nullptr) return send(packet);
+    if (packet.length > delta->capacity) {
+        // Too large for a delta frame: it goes out as is, and the next one is a keyframe
+        delta->valid = false;
+        return send(packet);
+    }
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> payloadLock(framePayloadMutex);
+#endif
+    return send(encodeDelta(*delta, packet, framePayload));
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryPacket ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::encodeDelta(DeltaSender& delta, const ofxBinaryPacket& packet, uint8_t* payload) {
+    uint8_t* body = payload + sizeof(DeltaHeader);
+    size_t bodyLength = 0;
+    bool keyframe = !delta.valid || delta.keyframeRequested || packet.length != delta.length ||
+        (delta.keyframeInterval > 0 && delta.sinceKeyframe + 1 >= delta.keyframeInterval);
+    
+    if (!keyframe) {
+        size_t bitmapLength = (packet.length + 7) / 8;
+        memset(body, 0, bitmapLength);
+        bodyLength = bitmapLength;
+        for (size_t i = 0; i < packet.length; ++i) {
+            if (packet.data[i] == delta.last[i]) continue;
+            if (bodyLength == packet.length) {
+                // No smaller than the whole payload
+                keyframe = true;
+                break;
+            }
+            body[i >> 3] |= 1 << (i & 7);
+            body[bodyLength++] = packet.data[i];
+        }
+    }
+    if (keyframe) {
+        memcpy(body, packet.data, packet.length);
+        bodyLength = packet.length;
+        delta.sinceKeyframe = 0;
+        delta.keyframeRequested = false;
+    }
+    else {
+        delta.sinceKeyframe++;
+    }
+    
+    DeltaHeader header;
+    header.payloadTopicId = packet.topicId;
+    header.sequence = ++delta.sequence;
+    header.keyframe = keyframe;
+    header.length = packet.length;
+    memcpy(payload, &header, sizeof(header));
+    
+    memcpy(delta.last, packet.data, packet.length);
+    delta.length = packet.length;
+    delta.valid = true;
+    return ofxBinaryPacket(DeltaHeader::topicId, sizeof(header) + bodyLength, payload);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::enableReliable(uint8_t topicId, uint16_t maxLength, uint8_t window) {
+    // 241 and above are reserved
+    if (topicId > 240 || window == 0 || window > 32 || sizeof(ReliableHeader) + (size_t)maxLength > MaxPacket) return false;
+    disableReliable(topicId);
+    
+    // A power of two keeps sequence % window continuous when the sequence wraps
+    uint8_t slotCount = 1;
+    while (slotCount < window) slotCount <<= 1;
+    
+    ReliableSender* reliable;
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(reliableMutex);
+    reliableSenders[topicId].reset(new ReliableSender());
+    reliable = reliableSenders[topicId].get();
+    reliableSenderCount++;
+    // A new session tells the receiver to forget what it knows of the previous one
+    uint16_t session = (uint16_t)std::random_device()();
+#else
+    if (reliableSenderCount >= MAX_RELIABLE_TOPICS) return false;
+    reliable = &reliableSenders[reliableSenderCount++];
+    uint16_t session = (uint16_t)(micros() ^ (micros() >> 16) ^ ((uint16_t)topicId << 8));
+#endif
+    reliable->topicId = topicId;
+    reliable->window = slotCount;
+    reliable->session = session;
+    reliable->base = 0;
+    reliable->next = 0;
+    reliable->srtt = 0;
+    reliable->rttvar = 0;
+    reliable->rto = ReliableInitialRtoMillis;
+    reliable->capacity = maxLength;
+    reliable->slots = new ReliableSlot[slotCount];
+    for (uint8_t i = 0; i < slotCount; ++i) {
+        reliable->slots[i].pending = false;
+    }
+    reliable->data = new uint8_t[(size_t)slotCount * maxLength > 0 ? (size_t)slotCount * maxLength : 1];
+    memset(&reliable->stats, 0, sizeof(reliable->stats));
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::disableReliable(uint8_t topicId) {
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(reliableMutex);
+    if (reliableSenders[topicId]) {
+        delete[] reliableSenders[topicId]->slots;
+        delete[] reliableSenders[topicId]->data;
+        reliableSenders[topicId].reset();
+        reliableSenderCount--;
+    }
+#else
+    for (uint8_t i = 0; i < reliableSenderCount; ++i) {
+        if (reliableSenders[i].topicId == topicId) {
+            delete[] reliableSenders[i].slots;
+            delete[] reliableSenders[i].data;
+            reliableSenders[i] = reliableSenders[--reliableSenderCount];
+            return;
+        }
+    }
+#endif
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::canSendReliable(uint8_t topicId) {
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(reliableMutex);
+#endif
+    ReliableSender* reliable = findReliableSender(topicId);
+    return reliable != nullptr && (uint16_t)(reliable->next - reliable->base) < reliable->window;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+typename ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getReliableStats(uint8_t topicId) {
+    ReliableStats stats;
+    memset(&stats, 0, sizeof(stats));
+    {
+#ifdef OF_VERSION_MAJOR
+        std::lock_guard<std::mutex> lock(reliableMutex);
+#endif
+        ReliableSender* reliable = findReliableSender(topicId);
+        if (reliable != nullptr) {
+            stats = reliable->stats;
+            stats.inFlight = reliable->next - reliable->base;
+            stats.rttMillis = reliable->srtt;
+            stats.rtoMillis = reliable->rto;
+        }
+    }
+    // Duplicates are counted by the receiving side
+    ReliableReceiver* receiver = findReliableReceiver(topicId, false);
+    if (receiver != nullptr) {
+        stats.duplicates = receiver->duplicates;
+    }
+    return stats;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+typename ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableSender* ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::findReliableSender(uint8_t topicId) {
+#ifdef OF_VERSION_MAJOR
+    return reliableSenders[topicId].get();
+#else
+    for (uint8_t i = 0; i < reliableSenderCount; ++i) {
+        if (reliableSenders[i].topicId == topicId) return &reliableSenders[i];
+    }
+    return nullptr;
+#endif
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+typename ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReliableReceiver* ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::findReliableReceiver(uint8_t topicId, bool create) {
+    ReliableReceiver* receiver = nullptr;
+#ifdef OF_VERSION_MAJOR
+    if (reliableReceivers[topicId] || !create) return reliableReceivers[topicId].get();
+    reliableReceivers[topicId].reset(new ReliableReceiver());
+    receiver = reliableReceivers[topicId].get();
+#else
+    for (uint8_t i = 0; i < reliableReceiverCount; ++i) {
+        if (reliableReceivers[i].topicId == topicId) return &reliableReceivers[i];
+    }
+    if (!create || reliableReceiverCount >= MAX_RELIABLE_TOPICS) return nullptr;
+    receiver = &reliableReceivers[reliableReceiverCount++];
+#endif
+    receiver->topicId = topicId;
+    receiver->valid = false;
+    receiver->duplicates = 0;
+    return receiver;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+uint32_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getMillis() {
+#ifdef OF_VERSION_MAJOR
+    return (uint32_t)ofGetElapsedTimeMillis();
+#else
+    return millis();
+#endif
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryPacket ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::encodeReliable(ReliableSender& reliable, uint16_t sequence, uint8_t* payload) {
+    uint8_t index = sequence % reliable.window;
+    ReliableHeader header;
+    header.payloadTopicId = reliable.topicId;
+    header.session = reliable.session;
+    header.sequence = sequence;
+    memcpy(payload, &header, sizeof(header));
+    memcpy(payload + sizeof(header), reliable.data + (size_t)index * reliable.capacity, reliable.slots[index].length);
+    return ofxBinaryPacket(ReliableHeader::topicId, sizeof(header) + reliable.slots[index].length, payload);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::resendReliable(ReliableSender& reliable, uint16_t sequence, uint32_t now) {
+    ReliableSlot& slot = reliable.slots[sequence % reliable.window];
+    slot.sentMillis = now;
+    slot.retries++;
+    reliable.stats.retransmitted++;
+    
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(framePayloadMutex);
+#endif
+    ofxBinaryPacket frame = encodeReliable(reliable, sequence, framePayload);
+#ifdef OF_VERSION_MAJOR
+    if (sendThreaded) {
+        queueFrame(frame, sendPriorities[reliable.topicId]);
+        return;
+    }
+#endif
+    bufferFrame(frame);
+    flushSendBuffer();
+}
+
+// Mark one packet as acknowledged and fold its round trip time into the timeout
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::acknowledgeReliable(ReliableSender& reliable, uint16_t sequence, uint32_t now) {
+    ReliableSlot& slot = reliable.slots[sequence % reliable.window];
+    if (!slot.pending || slot.sequence != sequence) return;
+    slot.pending = false;
+    reliable.stats.acked++;
+    // A packet that was sent again can't tell which copy was acknowledged (Karn)
+    if (slot.retries > 0) return;
+    
+    uint32_t sample = now - slot.sentMillis;
+    if (sample > ReliableMaxRtoMillis) sample = ReliableMaxRtoMillis;
+    if (reliable.srtt == 0) {
+        reliable.srtt = sample > 0 ? sample : 1;
+        reliable.rttvar = sample / 2;
+    }
+    else {
+        uint32_t deviation = reliable.srtt > sample ? reliable.srtt - sample : sample - reliable.srtt;
+        reliable.rttvar = (uint16_t)((3 * (uint32_t)reliable.rttvar + deviation) / 4);
+        reliable.srtt = (uint16_t)((7 * (uint32_t)reliable.srtt + sample) / 8);
+        if (reliable.srtt == 0) reliable.srtt = 1;
+    }
+    uint32_t rto = reliable.srtt + 4 * (uint32_t)reliable.rttvar;
+    if (rto < ReliableMinRtoMillis) rto = ReliableMinRtoMillis;
+    if (rto > ReliableMaxRtoMillis) rto = ReliableMaxRtoMillis;
+    reliable.rto = (uint16_t)rto;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receiveReliableAck(const ofxBinaryPacket& packet) {
+    ReliableAck ack;
+    if (!packet.unpack(ack)) return;
+    
+#ifdef OF_VERSION_MAJOR
+    std::lock_guard<std::mutex> lock(reliableMutex);
+#endif
+    ReliableSender* reliable = findReliableSender(ack.payloadTopicId);
+    if (reliable == nullptr || ack.session != reliable->session) return;
+    
+    uint16_t inFlight = reliable->next - reliable->base;
+    // Older than the window (a late ack) or ahead of anything sent
+    if ((uint16_t)(ack.cumulative - reliable->base) > inFlight) return;
+    
+    uint32_t now = getMillis();
+    for (uint16_t sequence = reliable->base; sequence != ack.cumulative; ++sequence) {
+        acknowledgeReliable(*reliable, sequence, now);
+    }
+    uint16_t highest = ack.cumulative;
+    for (uint8_t i = 0; i < 32; ++i) {
+        if (!(ack.selective & ((uint32_t)1 << i))) continue;
+        uint16_t sequence = ack.cumulative + 1 + i;
+        if ((uint16_t)(sequence - reliable->base) >= inFlight) break;
+        acknowledgeReliable(*reliable, sequence, now);
+        highest = sequence;
+    }
+    
+    // A later packet got through, so the missing ones before it were most likely lost:
+    // send them again now rather than after the timeout, at most once per round trip
+    uint16_t age = reliable->srtt > 0 ? reliable->srtt : 1;
+    for (uint16_t sequence = ack.cumulative; sequence != highest; ++sequence) {
+        ReliableSlot& slot = reliable->slots[sequence % reliable->window];
+        if (slot.pending && slot.sequence == sequence && slot.retries < ReliableMaxRetries && now - slot.sentMillis >= age) {
+            resendReliable(*reliable, sequence, now);
+        }
+    }
+    
+    while (reliable->base != reliable->next && !reliable->slots[reliable->base % reliable->window].pending) {
+        reliable->base++;
+    }
+}
+
+// Send again what timed out; returns how many packets were given up
+template<size_t MaxPacket, typename Checksum, typename Transport>
+uint8_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::retransmitReliable(ReliableSender& reliable, uint32_t now) {
+    uint8_t failed = 0;
+    bool timedOut = false;
+    for (uint16_t sequence = reliable.base; sequence != reliable.next; ++sequence) {
+        ReliableSlot& slot = reliable.slots[sequence % reliable.window];
+        if (!slot.pending || now - slot.sentMillis < reliable.rto) continue;
+        timedOut = true;
+        if (slot.retries >= ReliableMaxRetries) {
+            slot.pending = false;
+            reliable.stats.failed++;
+            failed++;
+            continue;
+        }
+        resendReliable(reliable, sequence, now);
+    }
+    if (timedOut) {
+        // Back off once per pass, not once per packet
+        uint32_t rto = 2 * (uint32_t)reliable.rto;
+        reliable.rto = (uint16_t)(rto < ReliableMaxRtoMillis ? rto : ReliableMaxRtoMillis);
+    }
+    while (reliable.base != reliable.next && !reliable.slots[reliable.base % reliable.window].pending) {
+        reliable.base++;
+    }
+    return failed;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+size_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::updateReliable() {
+    size_t failed = 0;
+    {
+        uint32_t now = getMillis();
+#ifdef OF_VERSION_MAJOR
+        std::lock_guard<std::mutex> lock(reliableMutex);
+        for (int topicId = 0; topicId < 256; ++topicId) {
+            if (reliableSenders[topicId]) {
+                failed += retransmitReliable(*reliableSenders[topicId], now);
+            }
+        }
+#else
+        for (uint8_t i = 0; i < reliableSenderCount; ++i) {
+            failed += retransmitReliable(reliableSenders[i], now);
+        }
+#endif
+    }
+    // Outside the lock: the handler may send
+    for (size_t i = 0; i < failed; ++i) {
+#ifdef OF_VERSION_MAJOR
+        dispatchError(ErrorType::DeliveryFailed);
+#else
+        notifyError(ErrorType::DeliveryFailed);
+#endif
+    }
+    return failed;
+}
+
+// Acknowledge a reliable frame and deliver its payload under its own topic, unless it is a duplicate
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receiveReliable(const ofxBinaryPacket& packet) {
+    ReliableHeader header;
+    if (packet.length < sizeof(header)) {
+#ifdef OF_VERSION_MAJOR
+        dispatchError(ErrorType::IncompletePacket);
+#else
+        notifyError(ErrorType::IncompletePacket);
+#endif
+        return;
+    }
+    memcpy(&header, packet.data, sizeof(header));
+    
+    // No ack when every receiver is in use (Arduino): the sender gives up with DeliveryFailed
+    ReliableReceiver* receiver = findReliableReceiver(header.payloadTopicId, true);
+    if (receiver == nullptr) return;
+    
+    uint16_t ahead = header.sequence - receiver->cumulative;
+    uint16_t behind = receiver->cumulative - header.sequence;
+    // A retransmission is never more than a window away: anything else is a restarted sender
+    if (!receiver->valid || header.session != receiver->session || (ahead > 32 && behind > 32)) {
+        receiver->valid = true;
+        receiver->session = header.session;
+        receiver->cumulative = header.sequence;
+        receiver->selective = 0;
+        ahead = 0;
+    }
+    
+    bool fresh;
+    if (ahead == 0) {
+        fresh = true;
+        receiver->cumulative++;
+        while (receiver->selective & 1) {
+            receiver->selective >>= 1;
+            receiver->cumulative++;
+        }
+        receiver->selective >>= 1;
+    }
+    else if (ahead <= 32) {
+        uint32_t bit = (uint32_t)1 << (ahead - 1);
+        fresh = !(receiver->selective & bit);
+        receiver->selective |= bit;
+    }
+    else {
+        fresh = false;
+    }
+    if (!fresh) receiver->duplicates++;
+    
+    // Duplicates are acknowledged too, the previous ack may be the one that was lost
+    ReliableAck ack;
+    ack.payloadTopicId = header.payloadTopicId;
+    ack.session = receiver->session;
+    ack.cumulative = receiver->cumulative;
+    ack.selective = receiver->selective;
+    send(ack);
+    
+    if (fresh) {
+        ofxBinaryPacket payload(header.payloadTopicId, packet.length - sizeof(header), packet.data + sizeof(header));
+#ifdef OF_VERSION_MAJOR
+        payload.arrivalMicros = packet.arrivalMicros;
+#endif
+        deliverPayload(payload);
+    }
+}
+
+// Notify methods for platform-specific callback/event handling
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::notifyReceived(const ofxBinaryPacket& packet) {
+#ifdef OF_VERSION_MAJOR
+    if (packet.topicId == Pong::topicId) {
+        // Take the time now, not after the receive queue or the executor
+        receivePong(packet);
+        return;
+    }
+    if (executorPort != nullptr && !isInternalTopic(packet.topicId)) {
+        // The handlers run on a worker; the packet is copied into the executor's pool
+        if (!executor->submit(executorPort, packet)) {
+            notifyError(ErrorType::BufferOverflow);
+        }
+        return;
+    }
+    if (receiveThreaded) {
+        // On the reader thread: hand the packet over to update()
+        ReceivedSlot* slot = queueSlot();
+        if (slot == nullptr) return;
+        slot->isError = false;
+        slot->topicId = packet.topicId;
+        slot->length = packet.length;
+        slot->arrivalMicros = packet.arrivalMicros;
+        memcpy(slot->data, packet.data, packet.length);
+        commitSlot();
+        return;
+    }
+    dispatchReceived(packet);
+#else
+    if (handleReservedPacket(packet)) return;
+    deliverPayload(packet);
+#endif
+}
+
+// Hand a user topic's packet to its handlers. Reserved topics that carry one (delta, reliable) end here too.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::deliverPayload(const ofxBinaryPacket& packet) {
+#ifdef OF_VERSION_MAJOR
+    if (executorPort != nullptr) {
+        if (!executor->submit(executorPort, packet)) {
+            dispatchError(ErrorType::BufferOverflow);
+        }
+        return;
+    }
+    deliverReceived(packet);
+#else
+    notifySubscriber(packet);
+    if (onReceived) {
+        onReceived(packet);
+    }
+#endif
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::notifySubscriber(const ofxBinaryPacket& packet) {
+#ifdef OF_VERSION_MAJOR
+    const auto& subscriber = subscribers[packet.topicId];
+    if (subscriber) {
+        subscriber(packet);
+    }
+#else
+    for (uint8_t i = 0; i < subscriptionCount; ++i) {
+        if (subscriptions[i].topicId == packet.topicId) {
+            subscriptions[i].invoker(packet, subscriptions[i].handler);
+            return;
+        }
+    }
+#endif
+}
+
+#ifndef OF_VERSION_MAJOR
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::addSubscription(uint8_t topicId, SubscriberInvoker invoker, SubscriberFunction handler) {
+    unsubscribe(topicId);
+    if (handler == nullptr) return true;
+    if (subscriptionCount >= MAX_SUBSCRIPTIONS) return false;
+    subscriptions[subscriptionCount].topicId = topicId;
+    subscriptions[subscriptionCount].invoker = invoker;
+    subscriptions[subscriptionCount].handler = handler;
+    subscriptionCount++;
+    return true;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::unsubscribe(uint8_t topicId) {
+    for (uint8_t i = 0; i < subscriptionCount; ++i) {
+        if (subscriptions[i].topicId == topicId) {
+            subscriptions[i] = subscriptions[--subscriptionCount];
+            return;
+        }
+    }
+}
+#endif
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::notifyError(ErrorType errorType) {
+#ifdef OF_VERSION_MAJOR
+    if (receiveThreaded) {
+        ReceivedSlot* slot = queueSlot();
+        if (slot == nullptr) return;
+        slot->isError = true;
+        slot->error = errorType;
+        commitSlot();
+        return;
+    }
+    dispatchError(errorType);
+#else
+#if LINK_STATS
+    errorCounts[(int)errorType].add(1);
+#endif
+    if (onError) {
+        onError(errorType);
+    }
+#endif
+}
+
+#if LINK_STATS
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::LinkStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getLinkStats() const {
+    LinkStats stats;
+    stats.rxBytes = rxBytes.get();
+    stats.rxFrames = rxFrames.get();
+    stats.rxPayloadBytes = rxPayloadBytes.get();
+    stats.rxEscapes = rxEscapes.get();
+    stats.txBytes = txBytes.get();
+    stats.txFrames = txFrames.get();
+    stats.txPayloadBytes = txPayloadBytes.get();
+    stats.txEscapes = txEscapes.get();
+    stats.resyncs = resyncs.get();
+    stats.skippedBytes = skippedBytes.get();
+    for (int i = 0; i < ErrorTypeCount; ++i) {
+        stats.errors[i] = errorCounts[i].get();
+    }
+    stats.maxBacklog = maxBacklog;
+    return stats;
+}
+
+#ifdef OF_VERSION_MAJOR
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::TopicStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getTopicStats(uint8_t topicId) const {
+    const TopicCounters& counters = topicCounters[topicId];
+    TopicStats stats;
+    stats.rxPackets = counters.rxPackets.get();
+    stats.rxBytes = counters.rxBytes.get();
+    stats.txPackets = counters.txPackets.get();
+    stats.txBytes = counters.txBytes.get();
+    return stats;
+}
+#endif
+#endif
+
+#ifdef OF_VERSION_MAJOR
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::dispatchReceived(const ofxBinaryPacket& packet) {
+    if (handleReservedPacket(packet)) return;
+    deliverReceived(packet);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::deliverReceived(const ofxBinaryPacket& packet) {
+    notifySubscriber(packet);
+    ofNotifyEvent(onReceived, packet);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setExecutor(std::shared_ptr<ofxBinaryCommunicatorExecutor> executor) {
+    if (executorPort != nullptr) {
+        this->executor->removePort(executorPort);
+        executorPort = nullptr;
+    }
+    this->executor = executor;
+    if (executor) {
+        executorPort = executor->addPort([this](const ofxBinaryPacket& packet) { deliverReceived(packet); });
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::dispatchError(ErrorType errorType) {
+#if LINK_STATS
+    errorCounts[(int)errorType].add(1);
+#endif
+    ofNotifyEvent(onError, errorType);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::reportWriteFailures() {
+    if (writeFailures == 0) return;
+    uint32_t count = writeFailures.exchange(0);
+    for (uint32_t i = 0; i < count; ++i) {
+        dispatchError(ErrorType::WriteFailed);
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setStreamHandler(uint8_t topicId, const StreamHandler& handler) {
+    streamHandlers[topicId].reset(new StreamHandler(handler));
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::beginStream() {
+    activeStream = streamHandlers[topicId].get();
+    streamChecksumState = ChecksumTraits::begin(receivingChecksumType);
+    streamStagedLength = 0;
+    if (activeStream->onBegin) activeStream->onBegin(topicId, packetLength);
+}
+
+// Escaped bytes are collected in receivedData and handed over in pieces
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::stageStreamByte(uint8_t byte) {
+    receivedData[streamStagedLength++] = byte;
+    if (streamStagedLength == MaxPacket) {
+        flushStreamChunk();
+    }
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::flushStreamChunk() {
+    if (streamStagedLength == 0) return;
+    deliverStreamChunk(receivedData, streamStagedLength);
+    streamStagedLength = 0;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::deliverStreamChunk(const uint8_t* data, size_t length) {
+    if (length == 0) return;
+    streamChecksumState = ChecksumTraits::update(receivingChecksumType, streamChecksumState, data, length);
+    if (activeStream->onChunk) activeStream->onChunk(data, length);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+bool ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::finishStream() {
+    flushStreamChunk();
+    StreamHandler* stream = activeStream;
+    activeStream = nullptr;
+    if (ChecksumTraits::finish(receivingChecksumType, streamChecksumState) == receivedChecksum) {
+        if (stream->onCommit) stream->onCommit();
+        return true;
+    }
+    if (stream->onAbort) stream->onAbort(ErrorType::ChecksumMismatch);
+    notifyError(ErrorType::ChecksumMismatch);
+    return false;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::abortStream(ErrorType error) {
+    StreamHandler* stream = activeStream;
+    activeStream = nullptr;
+    streamStagedLength = 0;
+    if (stream->onAbort) stream->onAbort(error);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::sendPing() {
+    Ping ping;
+    ping.sequence = nextPingSequence++;
+    ping.timestamp = (uint32_t)ofGetElapsedTimeMicros();
+    pingsSent++;
+    send(ping);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::setPingRate(float rateHz) {
+    pingIntervalMicros = rateHz > 0 ? (uint64_t)(1000000 / rateHz) : 0;
+    nextPingMicros = 0;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::PingStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getPingStats() const {
+    PingStats stats;
+    stats.sent = pingsSent;
+    std::lock_guard<std::mutex> lock(pingMutex);
+    stats.received = pingHistogram.getCount();
+    stats.minMicros = pingHistogram.getMin();
+    stats.p50Micros = pingHistogram.getValueAtPercentile(50);
+    stats.p99Micros = pingHistogram.getValueAtPercentile(99);
+    stats.p999Micros = pingHistogram.getValueAtPercentile(99.9);
+    stats.maxMicros = pingHistogram.getMax();
+    stats.meanMicros = pingHistogram.getMean();
+    return stats;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::resetPingStats() {
+    std::lock_guard<std::mutex> lock(pingMutex);
+    pingHistogram.reset();
+    pingsSent = 0;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+uint64_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::deviceToHostTime(uint32_t deviceMillis) const {
+    std::lock_guard<std::mutex> lock(pingMutex);
+    return clockSync.toHostMicros((uint64_t)deviceMillis * 1000) / 1000;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+uint64_t ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::deviceToHostMicros(uint32_t deviceMicros) const {
+    std::lock_guard<std::mutex> lock(pingMutex);
+    // Put it on the same wrap of micros() as the latest Pong
+    uint64_t latest = clockSync.getLatestRemoteMicros();
+    int64_t extended = (int64_t)latest + (int32_t)(deviceMicros - (uint32_t)latest);
+    return clockSync.toHostMicros(extended > 0 ? extended : 0);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+ofxBinaryCommunicatorBase::ClockSyncStats ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::getClockSyncStats() const {
+    uint64_t now = ofGetElapsedTimeMicros();
+    std::lock_guard<std::mutex> lock(pingMutex);
+    const ofxBinaryClockSync::Estimate& estimate = clockSync.getEstimate();
+    ClockSyncStats stats;
+    stats.synchronized = estimate.valid;
+    stats.offsetMicros = estimate.valid ? (double)(int64_t)(clockSync.toRemoteMicros(now) - now) : 0;
+    stats.driftPpm = estimate.drift * 1e6;
+    stats.minRoundTripMicros = estimate.minRoundTripMicros;
+    stats.samples = estimate.sampleCount;
+    return stats;
+}
+
+// The timestamp is this end's own clock, echoed back, so the round trip needs no clock sync.
+// uint32_t arithmetic keeps it right across the wrap every 71 minutes.
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receivePong(const ofxBinaryPacket& packet) {
+    Pong pong;
+    // A peer from before clock sync answers with sequence and timestamp only: that still gives a round trip
+    const size_t roundTripOnlyLength = offsetof(Pong, answerMicros);
+    bool roundTripOnly = packet.length == roundTripOnlyLength;
+    if (roundTripOnly) {
+        memcpy(&pong, packet.data, roundTripOnlyLength);
+    }
+    else if (!packet.unpack(pong)) {
+        return;
+    }
+    uint64_t received = packet.arrivalMicros > 0 ? packet.arrivalMicros : ofGetElapsedTimeMicros();
+    uint32_t roundTrip = (uint32_t)received - pong.timestamp;
+    if (roundTripOnly) {
+        std::lock_guard<std::mutex> lock(pingMutex);
+        pingHistogram.record(roundTrip);
+        return;
+    }
+    
+    // answerMillis * 1000 is the answering clock without the wraps of answerMicros, to the millisecond:
+    // the nearest value with answerMicros' low 32 bits is the full time
+    int64_t millisAsMicros = (int64_t)pong.answerMillis * 1000;
+    int64_t wraps = (millisAsMicros - (int64_t)pong.answerMicros + ((int64_t)1 << 31)) >> 32;
+    uint64_t remoteMicros = (uint64_t)pong.answerMicros + ((uint64_t)(wraps > 0 ? wraps : 0) << 32);
+    
+    std::lock_guard<std::mutex> lock(pingMutex);
+    pingHistogram.record(roundTrip);
+    clockSync.addSample(received - roundTrip, received, remoteMicros);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::requestDeltaKeyframe(uint8_t topicId) {
+    DeltaKeyframeRequest req;
+    req.payloadTopicId = topicId;
+    send(req);
+}
+
+// Rebuild a delta encoded payload on top of the previous one and deliver it under its own topic
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receiveDelta(const ofxBinaryPacket& packet) {
+    DeltaHeader header;
+    if (packet.length < sizeof(header)) {
+        dispatchError(ErrorType::IncompletePacket);
+        return;
+    }
+    memcpy(&header, packet.data, sizeof(header));
+    const uint8_t* body = packet.data + sizeof(header);
+    size_t bodyLength = packet.length - sizeof(header);
+    
+    std::unique_ptr<DeltaReceiver>& receiver = deltaReceivers[header.payloadTopicId];
+    if (!receiver) {
+        receiver.reset(new DeltaReceiver());
+        receiver->sequence = 0;
+        receiver->valid = false;
+        receiver->missed = 0;
+    }
+    
+    if (header.keyframe) {
+        if (bodyLength != header.length) {
+            dispatchError(ErrorType::IncompletePacket);
+            return;
+        }
+        receiver->last.assign(body, body + bodyLength);
+    }
+    else {
+        if (!receiver->valid || header.sequence != (uint8_t)(receiver->sequence + 1) || header.length != receiver->last.size()) {
+            // A frame was lost, the base is stale until the next keyframe.
+            // Ask for one now, and again every 32 frames in case the request is lost too.
+            receiver->valid = false;
+            if (receiver->missed++ % 32 == 0) {
+                requestDeltaKeyframe(header.payloadTopicId);
+            }
+            return;
+        }
+        size_t bitmapLength = (header.length + 7) / 8;
+        size_t changedCount = 0;
+        for (size_t i = 0; i < bitmapLength && i < bodyLength; ++i) {
+            for (uint8_t bits = body[i]; bits != 0; bits &= bits - 1) changedCount++;
+        }
+        if (bodyLength < bitmapLength || bodyLength - bitmapLength != changedCount) {
+            receiver->valid = false;
+            dispatchError(ErrorType::IncompletePacket);
+            return;
+        }
+        const uint8_t* changed = body + bitmapLength;
+        for (size_t i = 0; i < header.length; ++i) {
+            if (body[i >> 3] & (1 << (i & 7))) receiver->last[i] = *changed++;
+        }
+    }
+    receiver->sequence = header.sequence;
+    receiver->valid = true;
+    receiver->missed = 0;
+    
+    ofxBinaryPacket rebuilt(header.payloadTopicId, header.length, receiver->last.data());
+    rebuilt.arrivalMicros = packet.arrivalMicros;
+    deliverPayload(rebuilt);
+}
+
+// Fragments of one transfer arrive in order, so each one must continue where the last one ended.
+// A transfer whose start was lost is ignored (the lost frame was already reported).
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::receiveFragment(const ofxBinaryPacket& packet) {
+    FragmentHeader header;
+    if (packet.length < sizeof(header)) {
+        dispatchError(ErrorType::IncompletePacket);
+        return;
+    }
+    memcpy(&header, packet.data, sizeof(header));
+    const uint8_t* chunk = packet.data + sizeof(header);
+    uint16_t chunkLength = packet.length - sizeof(header);
+    
+    auto transfer = std::find_if(largeTransfers.begin(), largeTransfers.end(), [&header](const LargeTransfer& t) {
+        return t.topicId == header.payloadTopicId && t.transferId == header.transferId;
+    });
+    
+    if (header.offset == 0) {
+        if (transfer != largeTransfers.end()) {
+            releaseLargeTransfer(transfer); // restarted
+        }
+        if (largeTransfers.size() >= maxLargeTransfers) {
+            dispatchError(ErrorType::BufferOverflow);
+            return;
+        }
+        LargeTransfer t;
+        t.topicId = header.payloadTopicId;
+        t.transferId = header.transferId;
+        t.totalLength = header.totalLength;
+        t.receivedLength = 0;
+        t.arrivalMicros = packet.arrivalMicros;
+        if (!largeBufferPool.empty()) {
+            t.buffer = std::move(largeBufferPool.back());
+            largeBufferPool.pop_back();
+        }
+        t.buffer.resize(header.totalLength);
+        largeTransfers.push_back(std::move(t));
+        transfer = largeTransfers.end() - 1;
+    }
+    else if (transfer == largeTransfers.end()) {
+        return;
+    }
+    
+    if (header.offset != transfer->receivedLength || header.totalLength != transfer->totalLength ||
+        header.offset + chunkLength > transfer->totalLength) {
+        releaseLargeTransfer(transfer);
+        dispatchError(ErrorType::IncompletePacket);
+        return;
+    }
+    
+    memcpy(transfer->buffer.data() + header.offset, chunk, chunkLength);
+    transfer->receivedLength += chunkLength;
+    transfer->lastReceivedMillis = ofGetElapsedTimeMillis();
+    if (transfer->receivedLength < transfer->totalLength) return;
+    
+    // Take it out first, handlers may receive more
+    LargeTransfer complete = std::move(*transfer);
+    largeTransfers.erase(transfer);
+    ofxBinaryPacket payload(complete.topicId, complete.totalLength, complete.buffer.data());
+    payload.arrivalMicros = complete.arrivalMicros;
+    if (!handleReservedPacket(payload)) deliverPayload(payload);
+    largeBufferPool.push_back(std::move(complete.buffer));
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::releaseLargeTransfer(typename std::vector<LargeTransfer>::iterator transfer) {
+    largeBufferPool.push_back(std::move(transfer->buffer));
+    largeTransfers.erase(transfer);
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::expireLargeTransfers() {
+    uint64_t now = ofGetElapsedTimeMillis();
+    for (size_t i = 0; i < largeTransfers.size();) {
+        if (now - largeTransfers[i].lastReceivedMillis > largeTransferTimeoutMillis) {
+            releaseLargeTransfer(largeTransfers.begin() + i);
+            dispatchError(ErrorType::TransferTimeout);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+// Reserve a receive queue slot on the reader thread, applying the full-queue policy
+template<size_t MaxPacket, typename Checksum, typename Transport>
+typename ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::ReceivedSlot* ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::queueSlot() {
+    ReceivedSlot* slot = receiveQueue.beginPush();
+    while (slot == nullptr && receiveQueuePolicy == QueueFullPolicy::Block && receiveThreadRunning) {
+        ofSleepMillis(1);
+        slot = receiveQueue.beginPush();
+    }
+    if (slot == nullptr) {
+        receiveQueueDropped++;
+    }
+    return slot;
+}
+
+template<size_t MaxPacket, typename Checksum, typename Transport>
+void ofxBasicBinaryCommunicator<MaxPacket, Checksum, Transport>::commitSlot() {
+    receiveQueue.commitPush();
+    receiveQueueQueued++;
+    size_t depth = receiveQueue.size();
+    if (depth > receiveQueueHighWaterMark) {
+        receiveQueueHighWaterMark = depth;
+    }
+}
+#endif
@@ -0,0 +1,158 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Lock-free queue for exactly one producer thread and one consumer thread.
+// Slots are preallocated, so push/pop never allocate.
+// Producer: beginPush() -> fill the slot -> commitPush()
+// Consumer: front() -> read the slot -> pop()
+template<typename T>
+class ofxBinarySpscQueue {
+public:
+    ofxBinarySpscQueue() : head(0), tail(0) {}
+
+    // Not thread safe. Call before the threads start.
+    void allocate(size_t capacity) {
+        slots.assign(capacity + 1, T());
+        head.store(0);
+        tail.store(0);
+    }
+
+    size_t capacity() const { return slots.empty() ? 0 : slots.size() - 1; }
+
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return h >= t ? h - t : h + slots.size() - t;
+    }
+
+    // Producer side. Returns nullptr if the queue is full.
+    T* beginPush() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (next(h) == tail.load(std::memory_order_acquire)) return nullptr;
+        return &slots[h];
+    }
+
+    void commitPush() {
+        head.store(next(head.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    // Consumer side. Returns nullptr if the queue is empty.
+    T* front() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return nullptr;
+        return &slots[t];
+    }
+
+    void pop() {
+        tail.store(next(tail.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+private:
+    size_t next(size_t index) const {
+        return index + 1 == slots.size() ? 0 : index + 1;
+    }
+
+    std::vector<T> slots;
+
+    // Keep the indices on separate cache lines so the threads don't fight over them
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+// Bounded lock-free queue for any number of producers and consumers
+// (Dmitry Vyukov's sequence-numbered ring). The capacity is rounded up to a power of two.
+// push()/pop() take a function that fills or reads the slot in place.
+template<typename T>
+class ofxBinaryMpmcQueue {
+public:
+    ofxBinaryMpmcQueue() : mask(0), enqueuePos(0), dequeuePos(0) {}
+
+    // Not thread safe. Call before the threads start.
+    void allocate(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+        enqueuePos.store(0);
+        dequeuePos.store(0);
+    }
+
+    size_t capacity() const { return cells ? mask + 1 : 0; }
+
+    // Approximate while other threads are pushing or popping
+    size_t size() const {
+        size_t e = enqueuePos.load(std::memory_order_acquire);
+        size_t d = dequeuePos.load(std::memory_order_acquire);
+        return e > d ? e - d : 0;
+    }
+
+    // Returns false if the queue is full
+    template<typename Fill>
+    bool push(Fill fill) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(cell.data);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the queue is empty
+    template<typename Consume>
+    bool pop(Consume consume) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
+
+#endif
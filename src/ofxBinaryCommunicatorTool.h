@@ -1,60 +1,285 @@
 #pragma once
 
+#if defined(OF_VERSION_MAJOR) && defined(__linux__)
+    #include <dirent.h>
+    #include <limits.h>
+    #include <stdlib.h>
+#endif
+
 class ofxBinaryCommunicatorTool {
 #ifdef OF_VERSION_MAJOR
+public:
+    // Device to wait for in discoverDevices(). deviceId -1 matches any id.
+    struct DeviceQuery {
+        string deviceName;
+        int deviceId;
+
+        DeviceQuery(const string& deviceName, int deviceId = -1) : deviceName(deviceName), deviceId(deviceId) {}
+    };
+
+    // Open every serial port at once, broadcast DeviceInfoRequest and collect the DeviceInfoResponses.
+    // Returns port path -> response for every device that answered within timeoutSec.
+    // Returns as soon as each query in wanted has a match; with no queries it listens for the whole timeout.
+    // With queries, the ports where the device cache last saw them are tried first, and the other
+    // ports are only opened if that misses.
+    static map<string, DeviceInfoResponse> discoverDevices(int baudRate, const vector<DeviceQuery>& wanted = vector<DeviceQuery>(), float timeoutSec = 2.0f) {
+        auto probes = probeWithCache(baudRate, wanted, timeoutSec);
+        return getResponses(probes);
+    }
+
+    // Same, limited to the given ports (the cache is updated but not consulted)
+    static map<string, DeviceInfoResponse> discoverDevices(const vector<string>& ports, int baudRate, const vector<DeviceQuery>& wanted = vector<DeviceQuery>(), float timeoutSec = 2.0f) {
+        auto probes = openProbes(ports, baudRate);
+        probeDevices(probes, wanted, timeoutSec);
+        updateDeviceCache(probes);
+        return getResponses(probes);
+    }
+
+    static bool matches(const DeviceInfoResponse& info, const DeviceQuery& query) {
+        if (strcmp(info.deviceName, query.deviceName.c_str()) != 0) return false;
+        return query.deviceId == -1 || query.deviceId == info.deviceId;
+    }
+
     // PCに接続されているデバイスの中から、DeviceInfoRequestを使ってデバイス名で探し出すメソッド。
     // 戻り値がそのポート名で、見つからなければ空で返す。
     // deviceIdを指定するとその番号に一致するものを返し、未指定（-1）の場合はどの番号でもいいから見つかれば返す
-public:
-    static string findDeviceByDeviceInfo(int baudRate, string deviceName, int deviceId = -1){
-        string port = "";
-        ofxBinaryCommunicator com;
-        
-        vector<ofSerialDeviceInfo> deviceList = ofSerial().getDeviceList();
-        
-        for (auto& device : deviceList) {
-            bool deviceFounded = false;
-            com.setup(device.getDevicePath() , baudRate);
-            
-            // Set lambda as listener
-            ofEventListener listener = com.onReceived.newListener([&](const ofxBinaryPacket& packet) {
-                if (packet.topicId == DeviceInfoResponse::topicId) {
-                    DeviceInfoResponse res;
-                    if (packet.unpack(res)) {
-                        // デバイス名の一致を確認
-                        if (strcmp(res.deviceName, deviceName.c_str()) == 0) {
-                            // deviceId指定が -1 なら、名前だけで合致判定
-                            if (deviceId == -1) deviceFounded = true;
-                            
-                            // deviceIdが一致するか確認
-                            else if (deviceId == res.deviceId) deviceFounded = true;
-                        }
-                    }
-                }
-            });
-            
-            // Send a DeviceInfoRequest
-            // Wait for a response (this is a simplified example, you might need to handle this asynchronously)
-            
-            float startTime = ofGetElapsedTimef();
-            float timeout = 0.5; // sec
-            while (ofGetElapsedTimef() - startTime < timeout) {
-                com.send(DeviceInfoRequest());
-                ofSleepMillis(100);
-                com.update();
-                if (deviceFounded) break;
-            }
-            
-            // com.close();
-            
-            // Check if the received device name matches the target
-            if (deviceFounded) {
-                port = device.getDevicePath();
+    // 全ポートを同時に調べる（discoverDevices）
+    static string findDeviceByDeviceInfo(int baudRate, string deviceName, int deviceId = -1, float timeoutSec = 0.5f) {
+        DeviceQuery query(deviceName, deviceId);
+        auto devices = discoverDevices(baudRate, vector<DeviceQuery>(1, query), timeoutSec);
+        for (auto& device : devices) {
+            if (matches(device.second, query)) return device.first;
+        }
+        return "";
+    }
+
+    // Same search, but returns the communicator that found the device, still open, so the port
+    // isn't opened (and the board reset) a second time. nullptr if the device was not found.
+    // Packets other than the DeviceInfoResponse that arrived while probing are not delivered.
+    static unique_ptr<ofxBinaryCommunicator> connectDeviceByDeviceInfo(int baudRate, string deviceName, int deviceId = -1, float timeoutSec = 0.5f) {
+        DeviceQuery query(deviceName, deviceId);
+        auto probes = probeWithCache(baudRate, vector<DeviceQuery>(1, query), timeoutSec);
+        for (auto& probe : probes) {
+            if (probe->answered && matches(probe->info, query)) return std::move(probe->com);
+        }
+        return nullptr;
+    }
+
+    // Device cache: stable port id -> last DeviceInfoResponse seen there, one line per device.
+    // Defaults to ofxBinaryCommunicatorDevices.txt in the data folder. An empty path disables it.
+    static void setDeviceCachePath(const string& path) { deviceCachePath() = path; }
+    static const string& getDeviceCachePath() { return deviceCachePath(); }
+
+    // Name of the port that survives replugging and reboots: the /dev/serial/by-id link on Linux
+    // (it contains the USB serial number), the port path elsewhere.
+    static string getStablePortId(const string& port) {
+#ifdef __linux__
+        const string byIdDir = "/dev/serial/by-id/";
+        char target[PATH_MAX];
+        if (realpath(port.c_str(), target) == nullptr) return port;
+        DIR* dir = opendir(byIdDir.c_str());
+        if (dir == nullptr) return port;
+        string stableId = port;
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            string link = byIdDir + entry->d_name;
+            char resolved[PATH_MAX];
+            if (realpath(link.c_str(), resolved) != nullptr && strcmp(resolved, target) == 0) {
+                stableId = link;
                 break;
             }
         }
-        
+        closedir(dir);
+        return stableId;
+#else
         return port;
+#endif
+    }
+
+    static map<string, DeviceInfoResponse> loadDeviceCache() {
+        map<string, DeviceInfoResponse> cache;
+        if (deviceCachePath().empty()) return cache;
+        ifstream file(deviceCachePath());
+        string line;
+        while (getline(file, line)) {
+            // port \t name \t version \t deviceId
+            vector<string> fields = ofSplitString(line, "\t");
+            if (fields.size() != 4) continue;
+            DeviceInfoResponse info;
+            memset(&info, 0, sizeof(info));
+            strncpy(info.deviceName, fields[1].c_str(), sizeof(info.deviceName) - 1);
+            strncpy(info.version, fields[2].c_str(), sizeof(info.version) - 1);
+            info.deviceId = ofToInt(fields[3]);
+            cache[fields[0]] = info;
+        }
+        return cache;
+    }
+
+    static void saveDeviceCache(const map<string, DeviceInfoResponse>& cache) {
+        if (deviceCachePath().empty()) return;
+        ofstream file(deviceCachePath());
+        for (auto& entry : cache) {
+            file << entry.first << "\t" << entry.second.deviceName << "\t" << entry.second.version << "\t" << entry.second.deviceId << "\n";
+        }
+    }
+
+private:
+    // Port being probed
+    struct Probe {
+        string port;
+        unique_ptr<ofxBinaryCommunicator> com;
+        ofEventListener listener;
+        bool answered;
+        DeviceInfoResponse info;
+
+        explicit Probe(const string& port) : port(port), com(new ofxBinaryCommunicator()), answered(false) {}
     };
+
+    // Interval between DeviceInfoRequests to a silent port. Opening a port often resets the board,
+    // so the first requests can arrive before it is listening.
+    static constexpr float requestIntervalSec = 0.1f;
+
+    static string& deviceCachePath() {
+        static string path = ofToDataPath("ofxBinaryCommunicatorDevices.txt", true);
+        return path;
+    }
+
+    // Cached ports of the wanted devices first, then a full scan if any is still missing
+    // (a stale cache costs at most one extra timeout). The cache is only tried when every
+    // wanted device has a cached port, otherwise the full scan would follow anyway.
+    static vector<unique_ptr<Probe>> probeWithCache(int baudRate, const vector<DeviceQuery>& wanted, float timeoutSec) {
+        vector<unique_ptr<Probe>> probes;
+        if (!wanted.empty()) {
+            vector<string> cachedPorts;
+            vector<bool> cached(wanted.size(), false);
+            for (auto& entry : loadDeviceCache()) {
+                bool wantedPort = false;
+                for (size_t i = 0; i < wanted.size(); ++i) {
+                    if (matches(entry.second, wanted[i])) {
+                        cached[i] = true;
+                        wantedPort = true;
+                    }
+                }
+                if (wantedPort) cachedPorts.push_back(entry.first);
+            }
+            if (std::find(cached.begin(), cached.end(), false) == cached.end()) {
+                probes = openProbes(cachedPorts, baudRate);
+            }
+            if (!probes.empty()) {
+                probeDevices(probes, wanted, timeoutSec);
+                if (foundAll(getResponses(probes), wanted)) {
+                    updateDeviceCache(probes);
+                    return probes;
+                }
+            }
+        }
+
+        // Close the cached ports first, the full scan opens them again under their usual name
+        probes.clear();
+        vector<string> ports;
+        for (auto& device : ofSerial().getDeviceList()) {
+            ports.push_back(device.getDevicePath());
+        }
+        probes = openProbes(ports, baudRate);
+        probeDevices(probes, wanted, timeoutSec);
+        updateDeviceCache(probes);
+        return probes;
+    }
+
+    static vector<unique_ptr<Probe>> openProbes(const vector<string>& ports, int baudRate) {
+        vector<unique_ptr<Probe>> probes;
+        for (auto& port : ports) {
+            unique_ptr<Probe> probe(new Probe(port));
+            probe->com->setup(port, baudRate);
+            if (probe->com->isInitialized()) {
+                probes.push_back(std::move(probe));
+            }
+        }
+        return probes;
+    }
+
+    static void probeDevices(vector<unique_ptr<Probe>>& probes, const vector<DeviceQuery>& wanted, float timeoutSec) {
+        for (auto& probe : probes) {
+            Probe* p = probe.get();
+            p->listener = p->com->onReceived.newListener([p](const ofxBinaryPacket& packet) {
+                DeviceInfoResponse res;
+                if (!packet.unpack(res)) return;
+                res.deviceName[sizeof(res.deviceName) - 1] = '\0';
+                res.version[sizeof(res.version) - 1] = '\0';
+                p->info = res;
+                p->answered = true;
+            });
+        }
+
+        float startTime = ofGetElapsedTimef();
+        float lastRequestTime = -requestIntervalSec;
+        while (ofGetElapsedTimef() - startTime < timeoutSec) {
+            float now = ofGetElapsedTimef() - startTime;
+            if (now - lastRequestTime >= requestIntervalSec) {
+                for (auto& probe : probes) {
+                    if (!probe->answered) probe->com->send(DeviceInfoRequest());
+                }
+                lastRequestTime = now;
+            }
+
+            for (auto& probe : probes) {
+                probe->com->update();
+            }
+            if (!wanted.empty() && foundAll(getResponses(probes), wanted)) break;
+            ofSleepMillis(1);
+        }
+    }
+
+    static map<string, DeviceInfoResponse> getResponses(const vector<unique_ptr<Probe>>& probes) {
+        map<string, DeviceInfoResponse> devices;
+        for (auto& probe : probes) {
+            if (probe->answered) devices[probe->port] = probe->info;
+        }
+        return devices;
+    }
+
+    static bool foundAll(const map<string, DeviceInfoResponse>& devices, const vector<DeviceQuery>& wanted) {
+        for (auto& query : wanted) {
+            bool found = false;
+            for (auto& device : devices) {
+                if (matches(device.second, query)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+
+    static bool isSameInfo(const DeviceInfoResponse& a, const DeviceInfoResponse& b) {
+        return strcmp(a.deviceName, b.deviceName) == 0 && strcmp(a.version, b.version) == 0 && a.deviceId == b.deviceId;
+    }
+
+    // Remember where each device answered. A device seen on a new port replaces its old entry.
+    static void updateDeviceCache(const vector<unique_ptr<Probe>>& probes) {
+        if (deviceCachePath().empty()) return;
+        auto cache = loadDeviceCache();
+        bool changed = false;
+        for (auto& probe : probes) {
+            if (!probe->answered) continue;
+            string id = getStablePortId(probe->port);
+            for (auto it = cache.begin(); it != cache.end();) {
+                if (it->first != id && matches(it->second, DeviceQuery(probe->info.deviceName, probe->info.deviceId))) {
+                    it = cache.erase(it);
+                    changed = true;
+                }
+                else {
+                    ++it;
+                }
+            }
+            auto entry = cache.find(id);
+            if (entry == cache.end() || !isSameInfo(entry->second, probe->info)) {
+                cache[id] = probe->info;
+                changed = true;
+            }
+        }
+        if (changed) saveDeviceCache(cache);
+    }
 #endif
 };
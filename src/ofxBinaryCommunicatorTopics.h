@@ -23,3 +23,64 @@ TOPIC_STRUCT_MAKER(ErrorResponse, 251,
     char msg[32];
     ofxBinaryCommunicator::ErrorType e;
 )
+
+TOPIC_STRUCT_MAKER(ChecksumRequest, 249,
+    uint8_t checksumType; // ofxBinaryChecksumType
+)
+
+TOPIC_STRUCT_MAKER(ChecksumResponse, 248,
+    uint8_t checksumType;
+    bool accepted;
+)
+
+// One piece of a sendLarge() payload. The piece itself follows this header in the same packet.
+TOPIC_STRUCT_MAKER(FragmentHeader, 247,
+    uint16_t transferId;
+    uint8_t payloadTopicId; // topic of the whole payload
+    uint16_t totalLength;
+    uint16_t offset;
+)
+
+// Frame of a delta encoded topic (enableDelta()). A keyframe is followed by the whole payload, other
+// frames by a bitmap of the bytes that changed since the previous frame (bit i of byte i / 8) and then
+// those bytes in order.
+TOPIC_STRUCT_MAKER(DeltaHeader, 246,
+    uint8_t payloadTopicId;
+    uint8_t sequence; // +1 for every frame of the topic
+    uint8_t keyframe;
+    uint16_t length;  // length of the whole payload
+)
+
+// Asks the sender of a delta encoded topic to make its next frame a keyframe
+TOPIC_STRUCT_MAKER(DeltaKeyframeRequest, 245,
+    uint8_t payloadTopicId;
+)
+
+// Packet of a reliable topic (enableReliable()). The payload follows this header in the same packet.
+TOPIC_STRUCT_MAKER(ReliableHeader, 244,
+    uint8_t payloadTopicId;
+    uint16_t session;  // chosen by the sender on enableReliable(); a new one resets the receiver
+    uint16_t sequence; // +1 for every packet of the topic
+)
+
+// Acknowledges the packets of a reliable topic. Sent for every ReliableHeader packet, duplicates included.
+TOPIC_STRUCT_MAKER(ReliableAck, 243,
+    uint8_t payloadTopicId;
+    uint16_t session;
+    uint16_t cumulative; // every sequence before this one arrived
+    uint32_t selective;  // bit i: cumulative + 1 + i arrived too
+)
+
+// Round trip probe (sendPing()). The other end answers with a Pong in update(), both on Arduino and openFrameworks.
+// The exchange also synchronizes the clocks (deviceToHostTime()).
+TOPIC_STRUCT_MAKER(Ping, 242,
+    uint32_t sequence;
+    uint32_t timestamp; // sender's clock in microseconds, echoed back
+)
+
+TOPIC_STRUCT_MAKER(Pong, 241,
+    uint32_t sequence;
+    uint32_t timestamp;    // the Ping's timestamp
+    uint32_t answerMicros; // answering end's micros() when it answered
+    uint32_t answerMillis; // millis() at the same moment, tells how often answerMicros has wrapped
+)
@@ -0,0 +1,426 @@
+#include "ofxBinaryCommunicator.h"
+
+#ifdef OF_VERSION_MAJOR
+
+#if !defined(_WIN32)
+    #include <arpa/inet.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/ioctl.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <termios.h>
+    #include <unistd.h>
+#endif
+
+bool ofxBinaryTransport::waitReadable(int timeoutMillis) {
+    // No handle to wait on, so check again after a short sleep
+    if (available() > 0) return true;
+    if (timeoutMillis != 0) ofSleepMillis(1);
+    return available() > 0;
+}
+
+// ofSerial
+bool ofxBinarySerialTransport::isOpen() const {
+    return serial != nullptr && serial->isInitialized();
+}
+
+void ofxBinarySerialTransport::close() {
+    if (serial != nullptr) serial->close();
+}
+
+int ofxBinarySerialTransport::available() {
+    return isOpen() ? serial->available() : 0;
+}
+
+long ofxBinarySerialTransport::readSome(uint8_t* buffer, size_t length) {
+    if (!isOpen()) return 0;
+    long n = serial->readBytes(buffer, length);
+    return n > 0 ? n : 0;
+}
+
+long ofxBinarySerialTransport::writeSome(const uint8_t* data, size_t length) {
+    if (!isOpen()) return -1;
+    long n = serial->writeBytes(data, length);
+    if (n > 0 && baudRate > 0) {
+        uint64_t now = ofGetElapsedTimeMicros();
+        uint64_t drained = drainedMicros;
+        if (drained < now) drained = now;
+        drainedMicros = drained + (uint64_t)n * 10000000 / baudRate;
+    }
+    return n;
+}
+
+int ofxBinarySerialTransport::pendingWrite() {
+    if (baudRate <= 0) return -1;
+    uint64_t now = ofGetElapsedTimeMicros();
+    uint64_t drained = drainedMicros;
+    return drained > now ? (int)((drained - now) * baudRate / 10000000) : 0;
+}
+
+// Loopback
+ofxBinaryLoopbackTransport::Pair ofxBinaryLoopbackTransport::createPair(size_t capacity) {
+    auto a = std::make_shared<Pipe>();
+    auto b = std::make_shared<Pipe>();
+    a->buffer.resize(capacity);
+    b->buffer.resize(capacity);
+
+    std::shared_ptr<ofxBinaryLoopbackTransport> first(new ofxBinaryLoopbackTransport());
+    std::shared_ptr<ofxBinaryLoopbackTransport> second(new ofxBinaryLoopbackTransport());
+    first->rx = a;
+    first->tx = b;
+    second->rx = b;
+    second->tx = a;
+    return Pair(first, second);
+}
+
+bool ofxBinaryLoopbackTransport::isOpen() const {
+    std::lock_guard<std::mutex> lock(tx->mutex);
+    return !tx->closed;
+}
+
+void ofxBinaryLoopbackTransport::close() {
+    for (auto& pipe : {rx, tx}) {
+        std::lock_guard<std::mutex> lock(pipe->mutex);
+        pipe->closed = true;
+        pipe->changed.notify_all();
+    }
+}
+
+int ofxBinaryLoopbackTransport::available() {
+    std::lock_guard<std::mutex> lock(rx->mutex);
+    return (int)rx->size;
+}
+
+long ofxBinaryLoopbackTransport::readSome(uint8_t* buffer, size_t length) {
+    std::lock_guard<std::mutex> lock(rx->mutex);
+    Pipe& pipe = *rx;
+    if (pipe.size == 0 && pipe.closed) return -1;
+    size_t n = length < pipe.size ? length : pipe.size;
+    size_t capacity = pipe.buffer.size();
+    size_t first = capacity - pipe.head;
+    if (first > n) first = n;
+    memcpy(buffer, pipe.buffer.data() + pipe.head, first);
+    memcpy(buffer + first, pipe.buffer.data(), n - first);
+    pipe.head = (pipe.head + n) % capacity;
+    pipe.size -= n;
+    pipe.changed.notify_all();
+    return (long)n;
+}
+
+long ofxBinaryLoopbackTransport::writeSome(const uint8_t* data, size_t length) {
+    std::unique_lock<std::mutex> lock(tx->mutex);
+    Pipe& pipe = *tx;
+    size_t capacity = pipe.buffer.size();
+    pipe.changed.wait(lock, [&pipe, capacity] { return pipe.closed || pipe.size < capacity; });
+    if (pipe.closed) return -1;
+
+    size_t n = capacity - pipe.size;
+    if (n > length) n = length;
+    size_t tail = (pipe.head + pipe.size) % capacity;
+    size_t first = capacity - tail;
+    if (first > n) first = n;
+    memcpy(pipe.buffer.data() + tail, data, first);
+    memcpy(pipe.buffer.data(), data + first, n - first);
+    pipe.size += n;
+    pipe.changed.notify_all();
+    return (long)n;
+}
+
+int ofxBinaryLoopbackTransport::pendingWrite() {
+    std::lock_guard<std::mutex> lock(tx->mutex);
+    return (int)tx->size;
+}
+
+bool ofxBinaryLoopbackTransport::waitReadable(int timeoutMillis) {
+    std::unique_lock<std::mutex> lock(rx->mutex);
+    Pipe& pipe = *rx;
+    auto ready = [&pipe] { return pipe.size > 0 || pipe.closed; };
+    if (timeoutMillis < 0) {
+        pipe.changed.wait(lock, ready);
+    }
+    else {
+        pipe.changed.wait_for(lock, std::chrono::milliseconds(timeoutMillis), ready);
+    }
+    return pipe.size > 0;
+}
+
+#if !defined(_WIN32)
+
+// POSIX descriptor
+ofxBinaryFdTransport::ofxBinaryFdTransport(int fd) : fd(fd), isSocket(false) {
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        struct stat info;
+        isSocket = fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+#ifdef SO_NOSIGPIPE
+        // No MSG_NOSIGNAL on macOS: turn SIGPIPE off for the socket instead
+        int one = 1;
+        if (isSocket) setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    }
+}
+
+ofxBinaryFdTransport::~ofxBinaryFdTransport() {
+    close();
+}
+
+void ofxBinaryFdTransport::close() {
+    // The reading thread may close it at the end of the stream while another thread writes
+    int old = fd.exchange(-1);
+    if (old >= 0) ::close(old);
+}
+
+int ofxBinaryFdTransport::available() {
+    int n = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &n) < 0) return 0;
+    return n;
+}
+
+long ofxBinaryFdTransport::readSome(uint8_t* buffer, size_t length) {
+    if (fd < 0) return -1;
+    if (length == 0) return 0;
+    for (;;) {
+        ssize_t n = ::read(fd, buffer, length);
+        if (n > 0) return (long)n;
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        // End of the stream, or EIO from a pty whose other side closed
+        close();
+        return -1;
+    }
+}
+
+long ofxBinaryFdTransport::writeSome(const uint8_t* data, size_t length) {
+    if (fd < 0) return -1;
+    for (;;) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = isSocket ? ::send(fd, data, length, MSG_NOSIGNAL) : ::write(fd, data, length);
+#else
+        ssize_t n = ::write(fd, data, length);
+#endif
+        if (n >= 0) return (long)n;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+
+        // The descriptor is non-blocking for reads; wait for room like a blocking write would.
+        // A port that takes nothing for a second is treated as broken rather than stalling the writer.
+        pollfd p = {fd, POLLOUT, 0};
+        if (poll(&p, 1, 1000) <= 0) return -1;
+    }
+}
+
+bool ofxBinaryFdTransport::waitReadable(int timeoutMillis) {
+    if (fd < 0) return false;
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, timeoutMillis) <= 0) return false;
+    if ((p.revents & (POLLIN | POLLHUP | POLLERR)) && available() == 0) {
+        // Readable with nothing buffered: the stream has ended
+        close();
+        return false;
+    }
+    return (p.revents & POLLIN) != 0;
+}
+
+int ofxBinaryFdTransport::pendingWrite() {
+#ifdef TIOCOUTQ
+    int n = 0;
+    if (fd < 0 || ioctl(fd, TIOCOUTQ, &n) < 0) return -1;
+    return n;
+#else
+    return -1;
+#endif
+}
+
+// Pseudo-terminal
+ofxBinaryPtyTransport::Pair ofxBinaryPtyTransport::createPair() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0) return Pair();
+    if (grantpt(master) != 0 || unlockpt(master) != 0) {
+        ::close(master);
+        return Pair();
+    }
+
+    char* name = ptsname(master);
+    std::string path = name != nullptr ? name : "";
+    int slave = path.empty() ? -1 : open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        ::close(master);
+        return Pair();
+    }
+
+    // Raw mode: no echo, no line editing, no CR/LF translation
+    termios options;
+    tcgetattr(slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(slave, TCSANOW, &options);
+
+    return Pair(std::shared_ptr<ofxBinaryPtyTransport>(new ofxBinaryPtyTransport(master, path)),
+                std::shared_ptr<ofxBinaryPtyTransport>(new ofxBinaryPtyTransport(slave, path)));
+}
+
+// Serial port
+std::shared_ptr<ofxBinarySerialPortTransport> ofxBinarySerialPortTransport::open(const std::string& path, int baudRate) {
+    speed_t speed;
+    switch (baudRate) {
+        case 9600: speed = B9600; break;
+        case 19200: speed = B19200; break;
+        case 38400: speed = B38400; break;
+        case 57600: speed = B57600; break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+#ifdef B460800
+        case 460800: speed = B460800; break;
+#endif
+#ifdef B921600
+        case 921600: speed = B921600; break;
+#endif
+#ifdef B1000000
+        case 1000000: speed = B1000000; break;
+#endif
+#ifdef B2000000
+        case 2000000: speed = B2000000; break;
+#endif
+        default: return nullptr;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return nullptr;
+
+    termios options;
+    if (tcgetattr(fd, &options) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    cfmakeraw(&options);
+    options.c_cflag |= CLOCAL | CREAD;
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+    if (tcsetattr(fd, TCSANOW, &options) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return std::shared_ptr<ofxBinarySerialPortTransport>(new ofxBinarySerialPortTransport(fd, path));
+}
+
+// Sockets
+std::shared_ptr<ofxBinarySocketTransport> ofxBinarySocketTransport::connectTcp(const std::string& host, int port) {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), ofToString(port).c_str(), &hints, &result) != 0) return nullptr;
+
+    int fd = -1;
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) return nullptr;
+
+    // Frames are small and latency matters more than segment count
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return std::make_shared<ofxBinarySocketTransport>(fd);
+}
+
+std::shared_ptr<ofxBinarySocketTransport> ofxBinarySocketTransport::connectUnix(const std::string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return nullptr;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return nullptr;
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    return std::make_shared<ofxBinarySocketTransport>(fd);
+}
+
+bool ofxBinarySocketListener::listenTcp(int port, const std::string& host) {
+    close();
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) return false;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ofxBinarySocketListener::listenUnix(const std::string& path) {
+    close();
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        close();
+        return false;
+    }
+    unixPath = path;
+    return true;
+}
+
+void ofxBinarySocketListener::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (!unixPath.empty()) {
+        unlink(unixPath.c_str());
+        unixPath.clear();
+    }
+}
+
+std::shared_ptr<ofxBinarySocketTransport> ofxBinarySocketListener::accept(int timeoutMillis) {
+    if (fd < 0) return nullptr;
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, timeoutMillis) <= 0) return nullptr;
+
+    int client = ::accept(fd, nullptr, nullptr);
+    if (client < 0) return nullptr;
+    if (unixPath.empty()) {
+        int one = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return std::make_shared<ofxBinarySocketTransport>(client);
+}
+
+int ofxBinarySocketListener::getPort() const {
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (fd < 0 || getsockname(fd, (sockaddr*)&address, &length) != 0 || address.sin_family != AF_INET) return -1;
+    return ntohs(address.sin_port);
+}
+
+#endif
+
+#endif
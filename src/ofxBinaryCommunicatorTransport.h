@@ -0,0 +1,185 @@
+#pragma once
+
+#ifdef OF_VERSION_MAJOR
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ofSerial;
+
+// Byte stream used by ofxBinaryCommunicator (openFrameworks only).
+// setup(port, baudRate) uses ofxBinarySerialTransport; any other backend can be passed to setup(transport).
+// The concrete backends are final, so ofxBasicBinaryCommunicator<..., Backend> calls them without virtual dispatch.
+class ofxBinaryTransport {
+public:
+    virtual ~ofxBinaryTransport() {}
+
+    virtual bool isOpen() const = 0;
+    virtual void close() = 0;
+
+    // Bytes that can be read without waiting
+    virtual int available() = 0;
+
+    // Read what is there, up to length bytes. Never waits. Returns the number of bytes read (0 if none),
+    // or a negative value once the other end has closed the stream; the transport is closed then.
+    virtual long readSome(uint8_t* buffer, size_t length) = 0;
+
+    // Write up to length bytes. Returns the number of bytes written, or a negative value on error.
+    virtual long writeSome(const uint8_t* data, size_t length) = 0;
+
+    // Wait until something can be read. Returns false on timeout, and at once when the transport is closed.
+    virtual bool waitReadable(int timeoutMillis);
+
+    // File descriptor for poll/epoll, or -1 if the backend has none
+    virtual int getPollHandle() const { return -1; }
+
+    // Bytes written but not sent out yet (still in the OS or driver buffer), or -1 if unknown
+    virtual int pendingWrite() { return -1; }
+};
+
+// ofSerial backend. Does not own the ofSerial.
+// ofSerial can't tell how much is still in the TTY buffer, so pendingWrite() estimates it from
+// the baud rate (10 bits per byte). Without a baud rate it returns -1.
+class ofxBinarySerialTransport final : public ofxBinaryTransport {
+public:
+    explicit ofxBinarySerialTransport(ofSerial* serial, int baudRate = 0) : serial(serial), baudRate(baudRate), drainedMicros(0) {}
+
+    bool isOpen() const override;
+    void close() override;
+    int available() override;
+    long readSome(uint8_t* buffer, size_t length) override;
+    long writeSome(const uint8_t* data, size_t length) override;
+    int pendingWrite() override;
+
+private:
+    ofSerial* serial;
+    int baudRate;
+    std::atomic<uint64_t> drainedMicros; // when what was written so far is out, at baudRate
+};
+
+// In-memory pair. What one end writes, the other end reads.
+// writeSome() waits while the other end's buffer is full, like a blocking port.
+class ofxBinaryLoopbackTransport final : public ofxBinaryTransport {
+public:
+    typedef std::pair<std::shared_ptr<ofxBinaryLoopbackTransport>, std::shared_ptr<ofxBinaryLoopbackTransport>> Pair;
+    static Pair createPair(size_t capacity = 1 << 20);
+
+    bool isOpen() const override;
+    void close() override;
+    int available() override;
+    long readSome(uint8_t* buffer, size_t length) override;
+    long writeSome(const uint8_t* data, size_t length) override;
+    bool waitReadable(int timeoutMillis) override;
+    // What the other end hasn't read yet
+    int pendingWrite() override;
+
+private:
+    // One direction: ring buffer guarded by a mutex
+    struct Pipe {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<uint8_t> buffer;
+        size_t head = 0;
+        size_t size = 0;
+        bool closed = false;
+    };
+
+    std::shared_ptr<Pipe> rx;
+    std::shared_ptr<Pipe> tx;
+};
+
+#if !defined(_WIN32)
+
+// Backend for any non-blocking POSIX descriptor. Owns the descriptor.
+// The end of the stream (the peer closed the socket, the pty's other side or the device went away)
+// closes it, so a hub or receive thread stops waiting on it. writeSome() fails instead of raising
+// SIGPIPE when a socket's peer is gone, and when the descriptor takes no data for a second.
+class ofxBinaryFdTransport : public ofxBinaryTransport {
+public:
+    explicit ofxBinaryFdTransport(int fd);
+    ~ofxBinaryFdTransport();
+
+    bool isOpen() const override { return fd >= 0; }
+    void close() override;
+    int available() override;
+    long readSome(uint8_t* buffer, size_t length) override;
+    long writeSome(const uint8_t* data, size_t length) override;
+    bool waitReadable(int timeoutMillis) override;
+    int getPollHandle() const override { return fd; }
+    // TIOCOUTQ: serial ports, ptys and (on Linux) sockets
+    int pendingWrite() override;
+
+protected:
+    std::atomic<int> fd;
+    bool isSocket; // written with send(MSG_NOSIGNAL)
+};
+
+// Pseudo-terminal pair. The slave side behaves like a raw serial port,
+// so it can also be opened with ofSerial through getSlavePath().
+class ofxBinaryPtyTransport final : public ofxBinaryFdTransport {
+public:
+    typedef std::pair<std::shared_ptr<ofxBinaryPtyTransport>, std::shared_ptr<ofxBinaryPtyTransport>> Pair;
+
+    // Returns {master, slave}, or {nullptr, nullptr} on failure
+    static Pair createPair();
+
+    const std::string& getSlavePath() const { return slavePath; }
+
+private:
+    ofxBinaryPtyTransport(int fd, const std::string& slavePath) : ofxBinaryFdTransport(fd), slavePath(slavePath) {}
+
+    std::string slavePath;
+};
+
+// Serial port opened directly with termios (raw 8N1) instead of ofSerial, so it has a descriptor
+// for poll/epoll (ofxBinaryCommunicatorHub). Returns nullptr on failure or an unsupported baud rate.
+class ofxBinarySerialPortTransport final : public ofxBinaryFdTransport {
+public:
+    static std::shared_ptr<ofxBinarySerialPortTransport> open(const std::string& path, int baudRate);
+
+    const std::string& getPath() const { return path; }
+
+private:
+    ofxBinarySerialPortTransport(int fd, const std::string& path) : ofxBinaryFdTransport(fd), path(path) {}
+
+    std::string path;
+};
+
+// Connected TCP or Unix domain stream socket. Factories return nullptr on failure.
+class ofxBinarySocketTransport final : public ofxBinaryFdTransport {
+public:
+    explicit ofxBinarySocketTransport(int fd) : ofxBinaryFdTransport(fd) {}
+
+    static std::shared_ptr<ofxBinarySocketTransport> connectTcp(const std::string& host, int port);
+    static std::shared_ptr<ofxBinarySocketTransport> connectUnix(const std::string& path);
+};
+
+// Listening socket that accepts ofxBinarySocketTransport connections
+class ofxBinarySocketListener {
+public:
+    ofxBinarySocketListener() : fd(-1) {}
+    ~ofxBinarySocketListener() { close(); }
+
+    bool listenTcp(int port, const std::string& host = "127.0.0.1");
+    bool listenUnix(const std::string& path);
+    void close();
+
+    // Returns nullptr on timeout
+    std::shared_ptr<ofxBinarySocketTransport> accept(int timeoutMillis = -1);
+
+    // Actual port (useful after listenTcp(0))
+    int getPort() const;
+
+private:
+    int fd;
+    std::string unixPath;
+};
+
+#endif
+
+#endif